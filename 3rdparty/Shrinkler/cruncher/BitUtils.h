@@ -0,0 +1,29 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Bit manipulation helpers shared by the match finder and the hash tables.
+
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Index of the lowest set bit. x must not be zero.
+inline int lowestSetBit(uint64_t x) {
+#if defined(_MSC_VER)
+	unsigned long index;
+	if (_BitScanForward(&index, (unsigned long) x)) return (int) index;
+	_BitScanForward(&index, (unsigned long) (x >> 32));
+	return 32 + (int) index;
+#else
+	return __builtin_ctzll(x);
+#endif
+}
@@ -0,0 +1,205 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Parser which splits the data into blocks and parses them on several threads.
+
+Each block is parsed by its own LZParser together with some data on either
+side of it, so the paths of neighbouring blocks overlap. All parsers share
+the suffix index of the whole data, so references can point anywhere before
+the current position, also into earlier blocks.
+
+At each seam between two blocks the paths are joined at the position nearest
+to the seam which is not inside a reference of either path. If there is no
+such position in the overlap, the references crossing the seam are shortened.
+The joined path is usually slightly larger than the one found by parsing all
+data at once, since the parsers do not see the sizes of the paths leading
+into their blocks.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+
+using std::vector;
+
+#include "LZParser.h"
+#include "Parallel.h"
+
+// Overlap on each side of a block, as a fraction of the block size
+#define BLOCK_PARSER_OVERLAP_DIVISOR 8
+
+class BlockParser {
+	// Progress of a block, which is not reported, since blocks are parsed on several
+	// threads, but which stops when the progress of the whole parse stops.
+	class BlockProgress : public SilentProgress {
+		LZProgress *progress;
+	public:
+		BlockProgress(LZProgress *progress) : progress(progress) {}
+		virtual bool stopped() { return progress->stopped(); }
+	};
+
+	// Parsing state of one thread
+	struct Worker {
+		MatchFinder finder;
+		RefEdgeFactory edge_factory;
+		LZParser parser;
+
+		Worker(const unsigned char *data, int data_length, int zero_padding, const SuffixIndex& index, int match_patience, int max_same_length, bool use_range_index, int length_margin, int skip_length, int edge_capacity, const MatchTable *match_table)
+			: finder(index, 2, match_patience, max_same_length, use_range_index), edge_factory(edge_capacity),
+			parser(data, data_length, zero_padding, finder, length_margin, skip_length, &edge_factory, match_table)
+		{}
+	};
+
+	const unsigned char *data;
+	int data_length;
+	int zero_padding;
+	int block_size;
+	int overlap;
+	int num_blocks;
+	vector<Worker*> workers;
+
+	int blockBegin(int block) {
+		return max(0, block * block_size - overlap);
+	}
+
+	int blockEnd(int block) {
+		return min(data_length, (block + 1) * block_size + overlap);
+	}
+
+	// Whether pos is not inside a reference of the path, which must cover pos
+	static bool isBoundary(const vector<LZResultEdge>& path, int pos) {
+		int lo = 0;
+		int hi = (int) path.size();
+		while (lo < hi) {
+			int mid = (lo + hi) / 2;
+			if (path[mid].pos + path[mid].length <= pos) {
+				lo = mid + 1;
+			} else {
+				hi = mid;
+			}
+		}
+		return lo == (int) path.size() || path[lo].pos >= pos;
+	}
+
+	// Position at which to switch from the path of a block to the path of the next block
+	int findCut(const vector<LZResultEdge>& left, const vector<LZResultEdge>& right, int seam) {
+		for (int distance = 0 ; distance <= overlap ; distance++) {
+			int before = seam - distance;
+			if (isBoundary(left, before) && isBoundary(right, before)) return before;
+			int after = seam + distance;
+			if (after <= data_length && isBoundary(left, after) && isBoundary(right, after)) return after;
+		}
+		return seam;
+	}
+
+	// Append a reference to a path, joining it with the previous reference if that
+	// ends where it starts and has the same offset, which could not be encoded.
+	static void append(vector<LZResultEdge>& path, int pos, int offset, int length) {
+		if (length < 2) return;
+		if (!path.empty()) {
+			LZResultEdge& last = path.back();
+			if (last.pos + last.length == pos && last.offset == offset) {
+				last.length += length;
+				return;
+			}
+		}
+		path.push_back(LZResultEdge(pos, offset, length));
+	}
+
+public:
+	BlockParser(const unsigned char *data, int data_length, int zero_padding, const SuffixIndex& index, int match_patience, int max_same_length, bool use_range_index, int length_margin, int skip_length, int edge_capacity, const MatchTable *match_table, int block_size, int num_threads)
+		: data(data), data_length(data_length), zero_padding(zero_padding), block_size(block_size)
+	{
+		overlap = block_size / BLOCK_PARSER_OVERLAP_DIVISOR;
+		num_blocks = max(1, (data_length + block_size - 1) / block_size);
+		int num_workers = max(1, min(num_threads, num_blocks));
+		for (int t = 0 ; t < num_workers ; t++) {
+			workers.push_back(new Worker(data, data_length, zero_padding, index, match_patience, max_same_length, use_range_index, length_margin, skip_length, edge_capacity, match_table));
+		}
+	}
+
+	~BlockParser() {
+		for (int t = 0 ; t < (int) workers.size() ; t++) {
+			delete workers[t];
+		}
+	}
+
+	// The encoder is shared by all threads and must not change while parsing.
+	// The stopped method of the progress is called from all threads, and must keep
+	// returning true once it has returned true.
+	template <class Encoder>
+	LZParseResult parse(const Encoder& encoder, LZProgress *progress) {
+		progress->begin(data_length);
+
+		// Parse blocks, each giving a path of references in position order
+		vector<vector<LZResultEdge> > paths(num_blocks);
+		std::atomic<int> next_block(0);
+		std::atomic<int> parsed_blocks(0);
+		int num_workers = (int) workers.size();
+		parallelFor(num_workers, num_workers, [&](int t, int begin, int end) {
+			Worker *worker = workers[t];
+			BlockProgress block_progress(progress);
+			for (int b = next_block++ ; b < num_blocks && !progress->stopped() ; b = next_block++) {
+				worker->finder.reset();
+				LZParseResult block_result = worker->parser.parse(encoder, &block_progress, blockBegin(b), blockEnd(b));
+				if (!block_result.interrupted) {
+					paths[b].assign(block_result.edges.rbegin(), block_result.edges.rend());
+					parsed_blocks++;
+				}
+			}
+		});
+		if (parsed_blocks < num_blocks) {
+			progress->end();
+			LZParseResult result;
+			result.interrupted = true;
+			return result;
+		}
+
+		// Join paths at the seams, shortening references which cross a cut
+		vector<LZResultEdge> joined;
+		int cut_begin = 0;
+		for (int b = 0 ; b < num_blocks ; b++) {
+			int cut_end = b + 1 < num_blocks ? findCut(paths[b], paths[b + 1], (b + 1) * block_size) : data_length;
+			for (int i = 0 ; i < (int) paths[b].size() ; i++) {
+				const LZResultEdge& edge = paths[b][i];
+				int pos = max(edge.pos, cut_begin);
+				int target = min(edge.pos + edge.length, cut_end);
+				append(joined, pos, edge.offset, target - pos);
+			}
+			vector<LZResultEdge>().swap(paths[b]);
+			cut_begin = cut_end;
+		}
+
+		LZParseResult result;
+		result.data = data;
+		result.data_length = data_length;
+		result.zero_padding = zero_padding;
+		result.edges.assign(joined.rbegin(), joined.rend());
+
+		progress->end();
+
+		return result;
+	}
+
+	// Counts of all threads
+	LZParseCounts counts() const {
+		LZParseCounts counts;
+		for (int t = 0 ; t < (int) workers.size() ; t++) {
+			counts.add(workers[t]->parser.counts);
+		}
+		return counts;
+	}
+
+	// Include the reference statistics of all threads in those of the given factory
+	void mergeStatistics(RefEdgeFactory *edge_factory) {
+		for (int t = 0 ; t < (int) workers.size() ; t++) {
+			edge_factory->mergeStatistics(workers[t]->edge_factory);
+		}
+	}
+
+};
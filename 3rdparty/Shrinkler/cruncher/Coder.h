@@ -72,6 +72,16 @@ public:
 		has_cache = true;
 	}
 
+	// Get the cached sizes of the numbers using the given base context, indexed by number.
+	// Returns the number of cached sizes, or 0 if sizes are not cached for the context.
+	int cachedNumberSizes(int base_context, const unsigned short **sizes) const {
+		if (!has_cache) return 0;
+		int context_index = (base_context - number_context_offset) >> 8;
+		if (context_index < 0 || context_index >= n_number_contexts) return 0;
+		*sizes = &cache[context_index][0];
+		return cache[context_index].size();
+	}
+
 	// Number of fractional bits in the bit sizes returned by coding functions.
 	static const int BIT_PRECISION = 6;
 
@@ -82,11 +92,17 @@ public:
 	// Encode a number >= 2 using a variable-length encoding.
 	// Returns the coded size of the number (in fractional bits).
 	int encodeNumber(int base_context, int number) {
+		return encodeNumber(this, base_context, number);
+	}
+
+	// Encode a number using the given coder, calling the coding function of its type.
+	template <class CoderType>
+	static int encodeNumber(CoderType *coder, int base_context, int number) {
 		assert(number >= 2);
 
-		if (has_cache) {
-			int context_index = (base_context - number_context_offset) >> 8;
-			vector<unsigned short>& cache_for_context = cache[context_index];
+		if (coder->has_cache) {
+			int context_index = (base_context - coder->number_context_offset) >> 8;
+			vector<unsigned short>& cache_for_context = coder->cache[context_index];
 			if (number < cache_for_context.size()) {
 				return cache_for_context[number];
 			}
@@ -97,15 +113,15 @@ public:
 		int i;
 		for (i = 0 ; (4 << i) <= number ; i++) {
 			context = base_context + (i * 2 + 2);
-			size += code(context, 1);
+			size += coder->code(context, 1);
 		}
 		context = base_context + (i * 2 + 2);
-		size += code(context, 0);
+		size += coder->code(context, 0);
 
 		for (; i >= 0 ; i--) {
 			int bit = ((number >> i) & 1);
 			context = base_context + (i * 2 + 1);
-			size += code(context, bit);
+			size += coder->code(context, bit);
 		}
 
 		return size;
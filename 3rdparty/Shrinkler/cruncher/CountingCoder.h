@@ -19,7 +19,7 @@ struct ContextCounts {
 	int counts[2];
 };
 
-class CountingCoder : public Coder {
+class CountingCoder final : public Coder {
 	vector<ContextCounts> context_counts;
 
 	friend class SizeMeasuringCoder;
@@ -41,6 +41,12 @@ public:
 		}
 	}
 
+	// Add counts to a context, such as to give a first pass some prior knowledge
+	void addCounts(int context_index, int count0, int count1) {
+		context_counts[context_index].counts[0] += count0;
+		context_counts[context_index].counts[1] += count1;
+	}
+
 	virtual int code(int context_index, int bit) {
 		context_counts[context_index].counts[bit]++;
 		return 0;
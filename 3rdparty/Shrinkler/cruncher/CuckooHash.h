@@ -4,6 +4,9 @@
 
 Cuckoo hash map. Used for mapping offsets to edges in the LZ parser.
 
+The element arrays of maps can be drawn from a pool, which keeps released
+arrays for reuse by other maps instead of returning them to the heap.
+
 */
 
 #pragma once
@@ -11,11 +14,47 @@ Cuckoo hash map. Used for mapping offsets to edges in the LZ parser.
 #include <utility>
 #include <algorithm>
 #include <new>
+#include <vector>
 
 using std::pair;
+using std::vector;
 
 template <typename V> class CuckooHash;
 
+// Pool of element arrays for cuckoo hash maps, by size
+template <typename V>
+class CuckooHashPool {
+	vector<vector<pair<int, V>*> > free_arrays;
+
+public:
+	CuckooHashPool() {}
+
+	~CuckooHashPool() {
+		for (int size_log = 0 ; size_log < (int) free_arrays.size() ; size_log++) {
+			for (int i = 0 ; i < (int) free_arrays[size_log].size() ; i++) {
+				delete[] free_arrays[size_log][i];
+			}
+		}
+	}
+
+	pair<int, V>* allocate(int size_log) {
+		if (size_log < (int) free_arrays.size() && !free_arrays[size_log].empty()) {
+			pair<int, V>* array = free_arrays[size_log].back();
+			free_arrays[size_log].pop_back();
+			return array;
+		}
+		return new pair<int, V>[1 << size_log];
+	}
+
+	void release(pair<int, V>* array, int size_log) {
+		if (array == NULL) return;
+		if (size_log >= (int) free_arrays.size()) {
+			free_arrays.resize(size_log + 1);
+		}
+		free_arrays[size_log].push_back(array);
+	}
+};
+
 template <typename V>
 class CuckooHashIterator {
 	const CuckooHash<V>* table;
@@ -66,17 +105,22 @@ private:
 	static const hash_type HASH2_MUL = 0x8084027F;
 	static const int INITIAL_SIZE_LOG = 2;
 
+	CuckooHashPool<V>* pool;
 	value_type* element_array;
 	unsigned n_elements:26;
 	unsigned hash_shift:6;
 
+	int array_size_log() const {
+		return sizeof(hash_type) * 8 - hash_shift;
+	}
+
 	int array_size() const {
-		return 1 << (sizeof(hash_type) * 8 - hash_shift);
+		return 1 << array_size_log();
 	}
 
 	void init_array() {
 		int size = array_size();
-		element_array = new value_type[size];
+		element_array = pool != NULL ? pool->allocate(array_size_log()) : new value_type[size];
 		for (int i = 0 ; i < size ; i++) {
 			element_array[i].first = UNUSED;
 			element_array[i].second = V();
@@ -90,6 +134,14 @@ private:
 		return element_array;
 	}
 
+	void free_array(value_type* array, int size_log) {
+		if (pool != NULL) {
+			pool->release(array, size_log);
+		} else {
+			delete[] array;
+		}
+	}
+
 	void init() {
 		n_elements = 0;
 		hash_shift = sizeof(hash_type) * 8 - INITIAL_SIZE_LOG;
@@ -103,6 +155,7 @@ private:
 	}
 
 	void rehash() {
+		int old_size_log = array_size_log();
 		int old_size = array_size();
 		value_type* old_array = get_array();
 		n_elements = 0;
@@ -113,7 +166,7 @@ private:
 				(*this)[old_array[i].first] = old_array[i].second;
 			}
 		}
-		delete[] old_array;
+		free_array(old_array, old_size_log);
 	}
 
 	void insert(hash_type hash, int key, V value, int n) {
@@ -137,24 +190,35 @@ private:
 	}
 
 public:
-	CuckooHash() {
+	CuckooHash(CuckooHashPool<V>* pool = NULL) : pool(pool) {
 		init();
 	}
 
-	CuckooHash(const CuckooHash& source) {
+	CuckooHash(const CuckooHash& source) : pool(source.pool) {
 		// We only use copy for array initialization, so just create an empty map
 		init();
 	}
 
 	~CuckooHash() {
-		delete[] element_array;
+		free_array(element_array, array_size_log());
 	}
 
 	void clear() {
-		delete[] element_array;
+		free_array(element_array, array_size_log());
 		init();
 	}
 
+	void swap(CuckooHash& other) {
+		std::swap(pool, other.pool);
+		std::swap(element_array, other.element_array);
+		unsigned other_n_elements = other.n_elements;
+		unsigned other_hash_shift = other.hash_shift;
+		other.n_elements = n_elements;
+		other.hash_shift = hash_shift;
+		n_elements = other_n_elements;
+		hash_shift = other_hash_shift;
+	}
+
 	iterator begin() const {
 		return CuckooHashIterator<V>(this, 0);
 	}
@@ -193,6 +257,20 @@ public:
 		return 0;
 	}
 
+	// Value of a key, or NULL if the key is not in the map
+	V* find(int key) {
+		if (empty()) return NULL;
+
+		hash_type hash1;
+		hash_type hash2;
+		hashes(key, hash1, hash2);
+
+		value_type* array = element_array;
+		if (array[hash1].first == key) return &array[hash1].second;
+		if (array[hash2].first == key) return &array[hash2].second;
+		return NULL;
+	}
+
 	void erase(int key) {
 		hash_type hash1;
 		hash_type hash2;
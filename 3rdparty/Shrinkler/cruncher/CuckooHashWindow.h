@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Cuckoo hash maps for a sliding window of positions.
+
+The LZ parser keeps a map of the edges ending at each position ahead of the
+current one. Only the positions from the current one up to the furthest
+edge target hold edges, so the maps are kept in a ring indexed by position,
+which grows when an edge reaches beyond it. The map of a position is emptied
+when the window moves past it and reused for a later position. Element arrays
+are drawn from a pool shared by all maps of the window.
+
+*/
+
+#pragma once
+
+#include <vector>
+
+using std::vector;
+
+#include "CuckooHash.h"
+#include "assert.h"
+
+#define CUCKOO_HASH_WINDOW_INITIAL_SIZE 64
+
+template <typename V>
+class CuckooHashWindow {
+	CuckooHashPool<V> pool;
+	vector<CuckooHash<V> > maps;
+	int start;
+
+	int ring_index(int pos) const {
+		return pos & ((int) maps.size() - 1);
+	}
+
+	void grow(int size) {
+		int new_size = (int) maps.size();
+		while (new_size < size) new_size *= 2;
+		vector<CuckooHash<V> > new_maps(new_size, CuckooHash<V>(&pool));
+		for (int pos = start ; pos < start + (int) maps.size() ; pos++) {
+			new_maps[pos & (new_size - 1)].swap(maps[ring_index(pos)]);
+		}
+		maps.swap(new_maps);
+	}
+
+public:
+	CuckooHashWindow() : maps(CUCKOO_HASH_WINDOW_INITIAL_SIZE, CuckooHash<V>(&pool)), start(0) {}
+
+	// Start the window at the given position. All maps must be empty.
+	void reset(int pos) {
+		start = pos;
+	}
+
+	// Map of a position at or after the start of the window
+	CuckooHash<V>& operator[](int pos) {
+		assert(pos >= start);
+		if (pos - start >= (int) maps.size()) {
+			grow(pos - start + 1);
+		}
+		return maps[ring_index(pos)];
+	}
+
+	// Empty the map of the position at the start of the window and move the window past it
+	void consume(int pos) {
+		assert(pos == start);
+		maps[ring_index(pos)].clear();
+		start++;
+	}
+};
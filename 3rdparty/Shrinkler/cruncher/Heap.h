@@ -4,6 +4,11 @@
 
 Heap-based priority queue with removal support.
 
+The heap is d-ary with the given number of children per node. Each element
+is stored together with its key, so comparisons do not need to look up the
+keys through the elements. The key of an element must not change while it
+is in the heap.
+
 The element type must have an accessible _heap_index integer field.
 
 */
@@ -11,62 +16,72 @@ The element type must have an accessible _heap_index integer field.
 #pragma once
 
 #include <vector>
-#include <functional>
 
 using std::vector;
-using std::less;
 
-template <class T>
+template <class T, class Key, int ARITY>
 class Heap {
-	vector<T> elements;
-	less<T> compare;
-
-	void swap(int i1, int i2) {
-		T t1 = elements[i1];
-		T t2 = elements[i2];
-		elements[i1] = t2;
-		elements[i2] = t1;
-		t2->_heap_index = i1;
-		t1->_heap_index = i2;
+	struct Entry {
+		Key key;
+		T element;
+	};
+
+	vector<Entry> entries;
+
+	void place(int i, const Entry& entry) {
+		entries[i] = entry;
+		entry.element->_heap_index = i;
 	}
 
 	void up(int i) {
+		Entry entry = entries[i];
 		while (i > 0) {
-			int pi = (i-1)/2;
-			if (!compare(elements[pi], elements[i])) return;
-			swap(i, pi);
+			int pi = (i-1)/ARITY;
+			if (!(entries[pi].key < entry.key)) break;
+			place(i, entries[pi]);
 			i = pi;
 		}
+		place(i, entry);
 	}
 
 	void down(int i) {
-		while (i*2+1 < elements.size()) {
-			int ci1 = i*2+1;
-			int ci2 = i*2+2;
-			int ci = ci2 < elements.size() && compare(elements[ci1], elements[ci2]) ? ci2 : ci1;
-			if (!compare(elements[i], elements[ci])) return;
-			swap(i, ci);
+		Entry entry = entries[i];
+		int size = entries.size();
+		int ci;
+		while ((ci = i*ARITY+1) < size) {
+			// Largest child, first one if several are equal
+			int ci_end = ci + ARITY < size ? ci + ARITY : size;
+			Key child_key = entries[ci].key;
+			for (int c = ci + 1 ; c < ci_end ; c++) {
+				if (child_key < entries[c].key) {
+					ci = c;
+					child_key = entries[c].key;
+				}
+			}
+			if (!(entry.key < child_key)) break;
+			place(i, entries[ci]);
 			i = ci;
-		}		
+		}
+		place(i, entry);
 	}
 
 	T remove_index(int i) {
-		T removed = elements[i];
-		T last = elements[elements.size()-1];
-		elements[i] = last;
-		elements.pop_back();
-		last->_heap_index = i;
-		down(i);
+		T removed = entries[i].element;
+		entries[i] = entries.back();
+		entries.pop_back();
+		if (i < (int) entries.size()) {
+			down(i);
+		}
 		return removed;
 	}
 
 public:
 	Heap() {}
 
-	void insert(T t) {
-		elements.push_back(t);
-		t->_heap_index = elements.size()-1;
-		up(elements.size()-1);
+	void insert(T t, Key key) {
+		Entry entry = { key, t };
+		entries.push_back(entry);
+		up(entries.size()-1);
 	}
 
 	void remove(T t) {
@@ -80,15 +95,15 @@ public:
 	}
 
 	bool contains(T t) {
-		return t->_heap_index < elements.size() && elements[t->_heap_index] == t;
+		return t->_heap_index < entries.size() && entries[t->_heap_index].element == t;
 	}
 
 	int size() {
-		return elements.size();
+		return entries.size();
 	}
 
 	void clear() {
-		elements.clear();
+		entries.clear();
 	}
 
 };
@@ -77,7 +77,7 @@ public:
 
 class LZVerifier : public LZReceiver, public CompressedDataReadListener {
 	int hunk;
-	unsigned char *data;
+	const unsigned char *data;
 	int data_length;
 	int hunk_mem;
 	int pos;
@@ -91,7 +91,7 @@ public:
 	int compressed_longword_count;
 	int front_overlap_margin;
 
-	LZVerifier(int hunk, unsigned char *data, int data_length, int hunk_mem) : hunk(hunk), data(data), data_length(data_length), hunk_mem(hunk_mem), pos(0) {
+	LZVerifier(int hunk, const unsigned char *data, int data_length, int hunk_mem) : hunk(hunk), data(data), data_length(data_length), hunk_mem(hunk_mem), pos(0) {
 		compressed_longword_count = 0;
 		front_overlap_margin = 0;
 	}
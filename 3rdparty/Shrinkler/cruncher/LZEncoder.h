@@ -69,10 +69,14 @@ class LZState {
 	unsigned parity:1;
 	unsigned last_offset:28;
 
-	friend class LZEncoder;
+	friend class LZEncoding;
+	template <class CoderType, bool PARITY_CONTEXT> friend class SpecializedLZEncoder;
+	template <bool PARITY_CONTEXT> friend class MeasuringLZEncoder;
 };
 
-class LZEncoder {
+// Context layout and states shared by all encoders and the decoder
+class LZEncoding {
+protected:
 	static const int NUM_SINGLE_CONTEXTS = 1;
 	static const int NUM_CONTEXT_GROUPS = 4;
 	static const int CONTEXT_GROUP_SIZE = 256;
@@ -84,19 +88,22 @@ class LZEncoder {
 	static const int CONTEXT_GROUP_OFFSET = 2;
 	static const int CONTEXT_GROUP_LENGTH = 3;
 
-	Coder *coder;
-	int parity_mask;
+	friend class LZDecoder;
 
-	int code(int context, int bit) const {
-		return coder->code(NUM_SINGLE_CONTEXTS + context, bit);
+	static void literalState(const LZState *state_before, LZState *state_after) {
+		state_after->after_first = 1;
+		state_after->prev_was_ref = 0;
+		state_after->parity = state_before->parity + 1;
+		state_after->last_offset = state_before->last_offset;
 	}
 
-	int encodeNumber(int context_group, int number) const {
-		return coder->encodeNumber(NUM_SINGLE_CONTEXTS + (context_group << 8), number);
+	static void referenceState(int offset, int length, const LZState *state_before, LZState *state_after) {
+		state_after->after_first = 1;
+		state_after->prev_was_ref = 1;
+		state_after->parity = state_before->parity + length;
+		state_after->last_offset = offset;
 	}
 
-	friend class LZDecoder;
-
 public:
 	static const int KIND_LIT = 0;
 	static const int KIND_REF = 1;
@@ -105,8 +112,9 @@ public:
 	static const int NUMBER_CONTEXT_OFFSET = (NUM_SINGLE_CONTEXTS + CONTEXT_GROUP_OFFSET * CONTEXT_GROUP_SIZE);
 	static const int NUM_NUMBER_CONTEXTS = 2;
 
-	LZEncoder(Coder *coder, bool parity_context) : coder(coder), parity_mask(parity_context ? 1 : 0) {
-
+	// Index of the coder context of the bit selecting between literal and reference
+	static int kindContextIndex(int parity) {
+		return NUM_SINGLE_CONTEXTS + CONTEXT_KIND + ((parity & 1) << 8);
 	}
 
 	void setInitialState(LZState *state) const {
@@ -122,9 +130,34 @@ public:
 		state->parity = pos;
 		state->last_offset = last_offset;
 	}
+};
+
+// Encoder for a given coder type and parity setting.
+// If the coder type is a final class, its coding functions are called directly
+// and can be inlined, and the parity setting is resolved at compile time.
+template <class CoderType, bool PARITY_CONTEXT>
+class SpecializedLZEncoder : public LZEncoding {
+	CoderType *coder;
+
+	int code(int context, int bit) const {
+		return coder->code(NUM_SINGLE_CONTEXTS + context, bit);
+	}
+
+	int encodeNumber(int context_group, int number) const {
+		return Coder::encodeNumber(coder, NUM_SINGLE_CONTEXTS + (context_group << 8), number);
+	}
+
+	static int parityOffset(const LZState *state) {
+		return PARITY_CONTEXT ? (state->parity & 1) << 8 : 0;
+	}
+
+public:
+	SpecializedLZEncoder(CoderType *coder) : coder(coder) {
+
+	}
 
 	int encodeLiteral(unsigned char value, const LZState *state_before, LZState *state_after) const {
-		int parity_offset = (state_before->parity & parity_mask) << 8;
+		int parity_offset = parityOffset(state_before);
 		int size = 0;
 		if (state_before->after_first) {
 			size += code(CONTEXT_KIND + parity_offset, KIND_LIT);
@@ -136,11 +169,7 @@ public:
 			context = (context << 1) | bit;
 		}
 
-		state_after->after_first = 1;
-		state_after->prev_was_ref = 0;
-		state_after->parity = state_before->parity + 1;
-		state_after->last_offset = state_before->last_offset;
-
+		literalState(state_before, state_after);
 		return size;
 	}
 
@@ -149,7 +178,7 @@ public:
 		assert(length >= 2);
 		assert(state_before->after_first);
 
-		int parity_offset = (state_before->parity & parity_mask) << 8;
+		int parity_offset = parityOffset(state_before);
 		int size = code(CONTEXT_KIND + parity_offset, KIND_REF);
 		int rep_offset = offset == state_before->last_offset;
 		if (!state_before->prev_was_ref) {
@@ -162,16 +191,12 @@ public:
 		}
 		size += encodeNumber(CONTEXT_GROUP_LENGTH, length);
 
-		state_after->after_first = 1;
-		state_after->prev_was_ref = 1;
-		state_after->parity = state_before->parity + length;
-		state_after->last_offset = offset;
-
+		referenceState(offset, length, state_before, state_after);
 		return size;
 	}
 
 	int finish(const LZState *state_before) const {
-		int parity_offset = (state_before->parity & parity_mask) << 8;
+		int parity_offset = parityOffset(state_before);
 		int size = code(CONTEXT_KIND + parity_offset, KIND_REF);
 		if (!state_before->prev_was_ref) {
 			size += code(CONTEXT_REPEATED, 0);
@@ -184,3 +209,32 @@ public:
 	}
 };
 
+// Encoder for any coder, with the parity setting chosen at runtime
+class LZEncoder : public LZEncoding {
+	SpecializedLZEncoder<Coder, false> encoder;
+	SpecializedLZEncoder<Coder, true> parity_encoder;
+	bool parity_context;
+
+public:
+	LZEncoder(Coder *coder, bool parity_context) : encoder(coder), parity_encoder(coder), parity_context(parity_context) {
+
+	}
+
+	int encodeLiteral(unsigned char value, const LZState *state_before, LZState *state_after) const {
+		return parity_context
+			? parity_encoder.encodeLiteral(value, state_before, state_after)
+			: encoder.encodeLiteral(value, state_before, state_after);
+	}
+
+	int encodeReference(int offset, int length, const LZState *state_before, LZState *state_after) const {
+		return parity_context
+			? parity_encoder.encodeReference(offset, length, state_before, state_after)
+			: encoder.encodeReference(offset, length, state_before, state_after);
+	}
+
+	int finish(const LZState *state_before) const {
+		return parity_context
+			? parity_encoder.finish(state_before)
+			: encoder.finish(state_before);
+	}
+};
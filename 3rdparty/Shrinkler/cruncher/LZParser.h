@@ -37,6 +37,8 @@ parses to free up space.
 #include <utility>
 #include <list>
 #include <algorithm>
+#include <new>
+#include <stdint.h>
 
 using std::map;
 using std::max;
@@ -47,10 +49,16 @@ using std::vector;
 
 #include "LZEncoder.h"
 #include "MatchFinder.h"
+#include "MatchTable.h"
 #include "Heap.h"
 #include "CuckooHash.h"
+#include "CuckooHashWindow.h"
+#include "SwissHash.h"
 #include "assert.h"
 
+// Number of positions between checks whether parsing should stop
+#define LZPARSER_STOP_CHECK_INTERVAL 1024
+
 // For each offset:
 //   Best total size with last ref having that offset
 
@@ -60,16 +68,13 @@ class RefEdge {
 	int length;
 	int total_size;
 	int refcount;
-	RefEdge *source;
+	// Index of the source edge in the RefEdgeFactory, or -1 for none
+	int source;
 
-	RefEdge(int pos, int offset, int length, int total_size, RefEdge *source)
+	RefEdge(int pos, int offset, int length, int total_size, int source)
 		: pos(pos), offset(offset), length(length), total_size(total_size), source(source)
 	{
-		assert(source != this);
 		refcount = 1;
-		if (source != NULL) {
-			source->refcount++;
-		}
 		_heap_index = 0;
 	}
 
@@ -81,42 +86,65 @@ class RefEdge {
 	friend class LZParser;
 	friend struct LZResultEdge;
 	friend class LZParseResult;
-	friend struct std::less<RefEdge*>;
 
 public:
 	int _heap_index;
 };
 
-namespace std {
-	template <> struct less<RefEdge*> {
-		bool operator()(RefEdge* const & e1, RefEdge* const & e2) const {
-			return e1->total_size < e2->total_size;
-		}
-	};
-}
-
-// Factory for RefEdge objects which recycles destroyed objects for efficiency
+// Factory for RefEdge objects which recycles destroyed objects for efficiency.
+// Edges are allocated from slabs which never move. The first slab has room for
+// edge_capacity edges. Further slabs are added if more edges are alive at once.
+// Edges refer to their source by a 32 bit index into the slabs rather than by
+// pointer, and destroyed edges are kept in a free list threaded through these indices.
 class RefEdgeFactory {
 	int edge_capacity;
 	int edge_count;
 	int cleaned_edges;
 
-	RefEdge* buffer;
+	vector<RefEdge*> slabs;
+	vector<int> slab_start;
+	vector<int> slab_size;
+	int allocated;
+	int free_list;
+
+	// Each new slab doubles the total number of edges
+	void addSlab() {
+		int size = slabs.empty() ? max(edge_capacity, 1) : allocated;
+		slabs.push_back(static_cast<RefEdge*>(::operator new(sizeof(RefEdge) * (size_t) size)));
+		slab_start.push_back(allocated);
+		slab_size.push_back(size);
+	}
+
+	int index(RefEdge *edge) {
+		uintptr_t p = (uintptr_t) edge;
+		for (int s = 0 ; s < (int) slabs.size() ; s++) {
+			uintptr_t begin = (uintptr_t) slabs[s];
+			if (p >= begin && p < begin + sizeof(RefEdge) * (size_t) slab_size[s]) {
+				return slab_start[s] + (int) (edge - slabs[s]);
+			}
+		}
+		assert(false);
+		return -1;
+	}
+
 public:
 	int max_edge_count;
 	int max_cleaned_edges;
 
+	// Number of edges created and cleaned, over all parses
+	long long total_edges;
+	long long total_cleaned_edges;
+
 	RefEdgeFactory(int edge_capacity) : edge_capacity(edge_capacity),
-		edge_count(0), cleaned_edges(0), max_edge_count(0), max_cleaned_edges(0)
+		edge_count(0), cleaned_edges(0), allocated(0), free_list(-1), max_edge_count(0), max_cleaned_edges(0),
+		total_edges(0), total_cleaned_edges(0)
 	{
-		buffer = NULL;
+		addSlab();
 	}
 
 	~RefEdgeFactory() {
-		while (buffer != NULL) {
-			RefEdge *edge = buffer;
-			buffer = buffer->source;
-			delete edge;
+		for (int s = 0 ; s < (int) slabs.size() ; s++) {
+			::operator delete(slabs[s]);
 		}
 	}
 
@@ -125,23 +153,50 @@ public:
 		cleaned_edges = 0;
 	}
 
+	RefEdge* edge(int index) {
+		int s = 0;
+		while (index >= slab_start[s] + slab_size[s]) s++;
+		return &slabs[s][index - slab_start[s]];
+	}
+
+	RefEdge* source(RefEdge *edge) {
+		return edge->source < 0 ? NULL : this->edge(edge->source);
+	}
+
 	RefEdge* create(int pos, int offset, int length, int total_size, RefEdge *source) {
 		max_edge_count = max(max_edge_count, ++edge_count);
-		if (buffer == NULL) {
-			return new RefEdge(pos, offset, length, total_size, source);
+		total_edges++;
+		int new_index;
+		if (free_list >= 0) {
+			new_index = free_list;
+			free_list = edge(free_list)->source;
 		} else {
-			RefEdge* edge = buffer;
-			buffer = edge->source;
-			return new (edge) RefEdge(pos, offset, length, total_size, source);
+			if (allocated == slab_start.back() + slab_size.back()) {
+				addSlab();
+			}
+			new_index = allocated++;
 		}
+		int source_index = -1;
+		if (source != NULL) {
+			source->refcount++;
+			source_index = index(source);
+		}
+		return new (edge(new_index)) RefEdge(pos, offset, length, total_size, source_index);
+	}
+
+	// Account for an edge which was not created because it would have been destroyed right away
+	void skip() {
+		max_edge_count = max(max_edge_count, edge_count + 1);
 	}
 
 	void destroy(RefEdge* edge, bool clean) {
-		edge->source = buffer;
-		buffer = edge;
+		int edge_index = index(edge);
+		edge->source = free_list;
+		free_list = edge_index;
 		edge_count--;
 		if (clean) {
 			max_cleaned_edges = max(max_cleaned_edges, ++cleaned_edges);
+			total_cleaned_edges++;
 		}
 	}
 
@@ -149,6 +204,14 @@ public:
 		return edge_count >= edge_capacity;
 	}
 
+	// Include the statistics of another factory, such as one used for part of the data
+	void mergeStatistics(const RefEdgeFactory& other) {
+		max_edge_count = max(max_edge_count, other.max_edge_count);
+		max_cleaned_edges = max(max_cleaned_edges, other.max_cleaned_edges);
+		total_edges += other.total_edges;
+		total_cleaned_edges += other.total_cleaned_edges;
+	}
+
 };
 
 class LZProgress {
@@ -157,9 +220,20 @@ public:
 	virtual void update(int pos) = 0;
 	virtual void end() = 0;
 
+	// Checked regularly while parsing. If true, the parse ends early and its result must not be used.
+	virtual bool stopped() { return false; }
+
 	virtual ~LZProgress() {}
 };
 
+// Progress which is not reported anywhere, such as for parsers running on several threads
+class SilentProgress : public LZProgress {
+public:
+	virtual void begin(int size) {}
+	virtual void update(int pos) {}
+	virtual void end() {}
+};
+
 struct LZResultEdge {
 	int pos;
 	int offset;
@@ -167,6 +241,8 @@ struct LZResultEdge {
 
 	LZResultEdge(RefEdge *edge) : pos(edge->pos), offset(edge->offset), length(edge->length) {}
 
+	LZResultEdge(int pos, int offset, int length) : pos(pos), offset(offset), length(length) {}
+
 	friend class LZParseResult;
 };
 
@@ -178,7 +254,14 @@ class LZParseResult {
 	int data_length;
 	int zero_padding;
 public:
-	result_size_t encode(const LZEncoder& result_encoder) const {
+	// Whether the parse was stopped before it was complete. The result then holds no references.
+	bool interrupted;
+
+	LZParseResult() : data(NULL), data_length(0), zero_padding(0), interrupted(false) {}
+
+	// The encoder can be an LZEncoder or a SpecializedLZEncoder
+	template <class Encoder>
+	result_size_t encode(const Encoder& result_encoder) const {
 		result_size_t size = 0;
 		int pos = 0;
 		LZState state;
@@ -207,23 +290,42 @@ public:
 	}
 
 	friend class LZParser;
+	friend class BlockParser;
+};
+
+// What a parser did, over all parses
+struct LZParseCounts {
+	// Matches considered as references
+	long long matches;
+	// Positions skipped after a match of at least skip_length
+	long long skipped_positions;
+
+	LZParseCounts() : matches(0), skipped_positions(0) {}
+
+	void add(const LZParseCounts& other) {
+		matches += other.matches;
+		skipped_positions += other.skipped_positions;
+	}
 };
 
 class LZParser {
 	const unsigned char *data;
 	int data_length;
 	int zero_padding;
+	int parse_begin;
+	int parse_end;
 	MatchFinder& finder;
+	const MatchTable* match_table;
 	int length_margin;
 	int skip_length;
-	const LZEncoder* encoderp;
 	RefEdgeFactory* edge_factory;
 
 	vector<int> literal_size;
-	vector<CuckooHash<RefEdge*> > edges_to_pos;
+	CuckooHashWindow<RefEdge*> edges_to_pos;
 	RefEdge* best;
-	CuckooHash<RefEdge*> best_for_offset;
-	Heap<RefEdge*> root_edges;
+	SwissHash<RefEdge*> best_for_offset;
+	// Binary, since the choice between edges of equal size depends on the heap layout
+	Heap<RefEdge*, int, 2> root_edges;
 
 	bool is_root(RefEdge *edge) {
 		return root_edges.contains(edge);
@@ -233,9 +335,26 @@ class LZParser {
 		root_edges.remove(edge);
 	}
 
+	// Release all edges of a parse which ends early at pos
+	void releaseAll(RefEdge *initial_best, int pos, int end) {
+		root_edges.clear();
+		for (int i = 0 ; i < best_for_offset.size() ; i++) {
+			releaseEdge(best_for_offset.value(i));
+		}
+		best_for_offset.clear();
+		while (pos < end) {
+			CuckooHash<RefEdge*>& edges = edges_to_pos[++pos];
+			for (CuckooHash<RefEdge*>::iterator it = edges.begin() ; it != edges.end() ; it++) {
+				releaseEdge(it->second);
+			}
+			edges_to_pos.consume(pos);
+		}
+		releaseEdge(initial_best);
+	}
+
 	void releaseEdge(RefEdge *edge, bool clean = false) {
 		while (edge != NULL) {
-			RefEdge *source = edge->source;
+			RefEdge *source = edge_factory->source(edge);
 			if (--edge->refcount == 0) {
 				assert(!is_root(edge));
 				edge_factory->destroy(edge, clean);
@@ -251,82 +370,140 @@ class LZParser {
 		if (root_edges.size() == 0) return false;
 		RefEdge *worst_edge = root_edges.remove_largest();
 		if (worst_edge == best || worst_edge == exclude) return true;
-		CuckooHash<RefEdge*>& container = worst_edge->target() > pos
-			? edges_to_pos[worst_edge->target()]
-			: best_for_offset;
+		if (worst_edge->target() > pos) {
+			remove_worst_edge(edges_to_pos[worst_edge->target()], worst_edge);
+		} else {
+			remove_worst_edge(best_for_offset, worst_edge);
+		}
+		return true;
+	}
+
+	template <typename Map>
+	void remove_worst_edge(Map& container, RefEdge *worst_edge) {
 		if (container.size() > 1 && container.count(worst_edge->offset) > 0) {
 			container.erase(worst_edge->offset);
 			releaseEdge(worst_edge, true);
 		}
-		return true;
 	}
 
-	void put_by_offset(CuckooHash<RefEdge*>& by_offset, RefEdge* edge) {
+	template <typename Map>
+	void put_by_offset(Map& by_offset, RefEdge* edge) {
 		assert(!is_root(edge));
-		if (by_offset.count(edge->offset) == 0) {
+		RefEdge** old = by_offset.find(edge->offset);
+		if (old == NULL) {
 			by_offset[edge->offset] = edge;
-			root_edges.insert(edge);
-		} else if (edge->total_size < by_offset[edge->offset]->total_size) {
-			RefEdge* old_edge = by_offset[edge->offset];
+			root_edges.insert(edge, edge->total_size);
+		} else if (edge->total_size < (*old)->total_size) {
+			RefEdge* old_edge = *old;
 			remove_root(old_edge);
 			releaseEdge(old_edge);
-			by_offset[edge->offset] = edge;
-			root_edges.insert(edge);
+			*old = edge;
+			root_edges.insert(edge, edge->total_size);
 		} else {
 			releaseEdge(edge);
 		}
 	}
 
-	void newEdge(RefEdge *source, int pos, int offset, int length) {
+	template <class Encoder>
+	void newEdge(const Encoder& encoder, RefEdge *source, int pos, int offset, int length) {
 		if (source && offset == source->offset && pos == source->target()) return;
-		int prev_target = source ? source->target() : 0;
+		int prev_target = source ? source->target() : parse_begin;
 		int new_target = pos + length;
-		LZState state_before;
-		LZState state_after;
-		encoderp->constructState(&state_before, pos, pos == prev_target, source ? source->offset : 0);
-		int size_before = (source ? source->total_size : literal_size[data_length]) - (literal_size[data_length] - literal_size[pos]);
-		int edge_size = encoderp->encodeReference(offset, length, &state_before, &state_after);
-		int size_after = literal_size[data_length] - literal_size[new_target];
+		int size_before = (source ? source->total_size : literal_size[parse_end]) - (literal_size[parse_end] - literal_size[pos]);
+		int size_after = literal_size[parse_end] - literal_size[new_target];
 		while (edge_factory->full()) {
 			if (!clean_worst_edge(pos, source)) break;
 		}
-		RefEdge *new_edge = edge_factory->create(pos, offset, length, size_before + edge_size + size_after, source);
-		put_by_offset(edges_to_pos[new_target], new_edge);
+
+		// An edge which is no smaller than the edge with the same offset and target
+		// would be discarded right away by put_by_offset, so do not create it.
+		// Check against a lower bound first, to avoid measuring the reference.
+		CuckooHash<RefEdge*>& edges = edges_to_pos[new_target];
+		RefEdge** incumbent = edges.find(offset);
+		if (incumbent != NULL && (*incumbent)->total_size <= size_before + size_after) {
+			edge_factory->skip();
+			return;
+		}
+		LZState state_before;
+		LZState state_after;
+		encoder.constructState(&state_before, pos, pos == prev_target, source ? source->offset : 0);
+		int edge_size = encoder.encodeReference(offset, length, &state_before, &state_after);
+		int total_size = size_before + edge_size + size_after;
+		if (incumbent != NULL && (*incumbent)->total_size <= total_size) {
+			edge_factory->skip();
+			return;
+		}
+		RefEdge *new_edge = edge_factory->create(pos, offset, length, total_size, source);
+		put_by_offset(edges, new_edge);
+	}
+
+	template <class Encoder>
+	void newEdges(const Encoder& encoder, int pos, int match_pos, int match_length, int *max_match_length) {
+		int offset = pos - match_pos;
+		if (match_length > parse_end - pos) {
+			match_length = parse_end - pos;
+		}
+		int min_length = match_length - length_margin;
+		if (min_length < 2) min_length = 2;
+		for (int length = min_length ; length <= match_length ; length++) {
+			newEdge(encoder, best, pos, offset, length);
+			if (best->offset != offset) {
+				RefEdge** best_with_offset = best_for_offset.find(offset);
+				if (best_with_offset != NULL) {
+					assert((*best_with_offset)->target() <= pos);
+					newEdge(encoder, *best_with_offset, pos, offset, length);
+				}
+			}
+		}
+		*max_match_length = max(*max_match_length, match_length);
 	}
 
 public:
-	LZParser(const unsigned char *data, int data_length, int zero_padding, MatchFinder& finder, int length_margin, int skip_length, RefEdgeFactory* edge_factory)
-		: data(data), data_length(data_length), zero_padding(zero_padding), finder(finder), length_margin(length_margin), skip_length(skip_length), edge_factory(edge_factory)
+	LZParseCounts counts;
+
+	// If a match table is given, matches are taken from the table where possible instead of from the match finder.
+	LZParser(const unsigned char *data, int data_length, int zero_padding, MatchFinder& finder, int length_margin, int skip_length, RefEdgeFactory* edge_factory, const MatchTable* match_table = NULL)
+		: data(data), data_length(data_length), zero_padding(zero_padding), parse_begin(0), parse_end(data_length), finder(finder), match_table(match_table), length_margin(length_margin), skip_length(skip_length), edge_factory(edge_factory)
 	{
-		// Initialize edges_to_pos array
-		edges_to_pos.resize(data_length + 1);
 		best = NULL;
 	}
 
-	LZParseResult parse(const LZEncoder& encoder, LZProgress *progress) {
-		progress->begin(data_length);
-		encoderp = &encoder;
+	// The encoder can be an LZEncoder or a SpecializedLZEncoder, which is faster
+	template <class Encoder>
+	LZParseResult parse(const Encoder& encoder, LZProgress *progress) {
+		return parse(encoder, progress, 0, data_length);
+	}
+
+	// Parse only the data from begin until end, as if it started with a literal at begin
+	// and was followed by literals. References can point to data before begin.
+	template <class Encoder>
+	LZParseResult parse(const Encoder& encoder, LZProgress *progress, int begin, int end) {
+		parse_begin = begin;
+		parse_end = end;
+		progress->begin(end - begin);
 
 		// Reset state
 		best_for_offset.clear();
 		root_edges.clear();
 		edge_factory->reset();
+		edges_to_pos.reset(begin + 1);
 
 		// Accumulate literal sizes
 		literal_size.resize(data_length + 1, 0);
 		int size = 0;
 		LZState literal_state;
-		encoder.setInitialState(&literal_state);
-		for (int i = 0 ; i < data_length ; i++) {
+		encoder.constructState(&literal_state, begin, false, 0);
+		for (int i = begin ; i < end ; i++) {
 			literal_size[i] = size;
 			size += encoder.encodeLiteral(data[i], &literal_state, &literal_state);
 		}
-		literal_size[data_length] = size;
+		literal_size[end] = size;
 
 		// Parse
-		RefEdge* initial_best = edge_factory->create(0, 0, 0, literal_size[data_length], NULL);
+		RefEdge* initial_best = edge_factory->create(begin, 0, 0, literal_size[end], NULL);
 		best = initial_best;
-		for (int pos = 1 ; pos <= data_length ; pos++) {
+		int last_stop_check = begin;
+		for (int pos = begin + 1 ; pos <= end ; pos++) {
 			// Assimilate edges ending here
 			for (CuckooHash<RefEdge*>::iterator it = edges_to_pos[pos].begin() ; it != edges_to_pos[pos].end() ; it++) {
 				RefEdge *edge = it->second;
@@ -336,55 +513,62 @@ public:
 				remove_root(edge);
 				put_by_offset(best_for_offset, edge);
 			}
-			edges_to_pos[pos].clear();
+			edges_to_pos.consume(pos);
 
 			// Add new edges according to matches
-			finder.beginMatching(pos);
-			int match_pos;
-			int match_length;
 			int max_match_length = 0;
-			while (finder.nextMatch(&match_pos, &match_length)) {
-				int offset = pos - match_pos;
-				if (match_length > data_length - pos) {
-					match_length = data_length - pos;
+			if (match_table != NULL && match_table->contains(pos)) {
+				for (int i = match_table->begin(pos) ; i < match_table->end(pos) ; i++) {
+					newEdges(encoder, pos, match_table->matchPos(i), match_table->matchLength(i), &max_match_length);
 				}
-				int min_length = match_length - length_margin;
-				if (min_length < 2) min_length = 2;
-				for (int length = min_length ; length <= match_length ; length++) {
-					newEdge(best, pos, offset, length);
-					if (best->offset != offset && best_for_offset.count(offset)) {
-						assert(best_for_offset[offset]->target() <= pos);
-						newEdge(best_for_offset[offset], pos, offset, length);
-					}
+				counts.matches += match_table->end(pos) - match_table->begin(pos);
+			} else {
+				finder.beginMatching(pos);
+				int match_pos;
+				int match_length;
+				while (finder.nextMatch(&match_pos, &match_length)) {
+					newEdges(encoder, pos, match_pos, match_length, &max_match_length);
+					counts.matches++;
 				}
-				max_match_length = max(max_match_length, match_length);
 			}
 
 			// If we have a very long match, skip ahead
 			if (max_match_length >= skip_length && !edges_to_pos[pos + max_match_length].empty()) {
 				root_edges.clear();
-				for (CuckooHash<RefEdge*>::iterator it = best_for_offset.begin() ; it != best_for_offset.end() ; it++) {
-					releaseEdge(it->second);
+				for (int i = 0 ; i < best_for_offset.size() ; i++) {
+					releaseEdge(best_for_offset.value(i));
 				}
 				best_for_offset.clear();
 				int target_pos = pos + max_match_length;
+				counts.skipped_positions += target_pos - 1 - pos;
 				while (pos < target_pos - 1) {
 					CuckooHash<RefEdge*>& edges = edges_to_pos[++pos];
 					for (CuckooHash<RefEdge*>::iterator it = edges.begin() ; it != edges.end() ; it++) {
 						releaseEdge(it->second);
 					}
-					edges.clear();
+					edges_to_pos.consume(pos);
 				}
 				best = initial_best;
 			}
 
-			progress->update(pos);
+			progress->update(pos - begin);
+			// Skipping ahead can step over any fixed position, so count from the last check
+			if (pos - last_stop_check >= LZPARSER_STOP_CHECK_INTERVAL) {
+				last_stop_check = pos;
+				if (progress->stopped()) {
+					releaseAll(initial_best, pos, end);
+					progress->end();
+					LZParseResult result;
+					result.interrupted = true;
+					return result;
+				}
+			}
 		}
 
 		// Clean unused paths
 		root_edges.clear();
-		for (CuckooHash<RefEdge*>::iterator it = best_for_offset.begin() ; it != best_for_offset.end() ; it++) {
-			RefEdge *edge = it->second;
+		for (int i = 0 ; i < best_for_offset.size() ; i++) {
+			RefEdge *edge = best_for_offset.value(i);
 			if (edge != best) {
 				releaseEdge(edge);
 			}
@@ -398,7 +582,7 @@ public:
 		RefEdge *edge = best;
 		while (edge->length > 0) {
 			result.edges.push_back(LZResultEdge(edge));
-			edge = edge->source;
+			edge = edge_factory->source(edge);
 		}
 		releaseEdge(edge);
 		releaseEdge(best);
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Longest common prefix array construction using the permuted LCP (PLCP).
+
+Kasai's algorithm visits the suffixes in text order, but looks up the rank
+of each suffix and its neighbour in the suffix array, which are random
+accesses into two large arrays. Here the suffix array neighbour of each
+suffix (Phi) is first stored in text order. The PLCP values are then
+computed in text order with a single random access per suffix, and are
+finally permuted into suffix array order.
+
+Common prefixes are extended by comparing 32, 16 or 8 bytes at a time.
+The widest comparison supported by the CPU is selected at runtime.
+
+*/
+
+#pragma once
+
+#include <string.h>
+#include <stdint.h>
+
+#include "BitUtils.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define LCP_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LCP_TARGET(t) __attribute__((target(t)))
+#else
+#define LCP_TARGET(t)
+#endif
+
+// Length of the common prefix of a and b, at most max bytes.
+int matchLengthScalar(const unsigned char *a, const unsigned char *b, int max) {
+	int n = 0;
+	while (n + 8 <= max) {
+		uint64_t x, y;
+		memcpy(&x, a + n, 8);
+		memcpy(&y, b + n, 8);
+		if (x != y) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			return n + __builtin_clzll(x ^ y) / 8;
+#else
+			return n + lowestSetBit(x ^ y) / 8;
+#endif
+		}
+		n += 8;
+	}
+	while (n < max && a[n] == b[n]) {
+		n++;
+	}
+	return n;
+}
+
+#ifdef LCP_X86
+
+LCP_TARGET("sse2")
+int matchLengthSSE2(const unsigned char *a, const unsigned char *b, int max) {
+	int n = 0;
+	while (n + 16 <= max) {
+		__m128i x = _mm_loadu_si128((const __m128i *) (a + n));
+		__m128i y = _mm_loadu_si128((const __m128i *) (b + n));
+		unsigned mask = (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) ^ 0xffffu;
+		if (mask) return n + lowestSetBit(mask);
+		n += 16;
+	}
+	return n + matchLengthScalar(a + n, b + n, max - n);
+}
+
+LCP_TARGET("avx2")
+int matchLengthAVX2(const unsigned char *a, const unsigned char *b, int max) {
+	int n = 0;
+	while (n + 32 <= max) {
+		__m256i x = _mm256_loadu_si256((const __m256i *) (a + n));
+		__m256i y = _mm256_loadu_si256((const __m256i *) (b + n));
+		unsigned mask = ~(unsigned) _mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+		if (mask) return n + lowestSetBit(mask);
+		n += 32;
+	}
+	return n + matchLengthSSE2(a + n, b + n, max - n);
+}
+
+bool cpuSupportsSSE2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 1);
+	return (info[3] & (1 << 26)) != 0;
+#else
+	return __builtin_cpu_supports("sse2");
+#endif
+}
+
+bool cpuSupportsAVX2() {
+#if defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	// The OS must save the AVX registers (OSXSAVE and AVX set, XMM and YMM state enabled)
+	if ((info[2] & (1 << 27 | 1 << 28)) != (1 << 27 | 1 << 28)) return false;
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+typedef int (*MatchLengthFunction)(const unsigned char *a, const unsigned char *b, int max);
+
+MatchLengthFunction selectMatchLength() {
+#ifdef LCP_X86
+	if (cpuSupportsAVX2()) return matchLengthAVX2;
+	if (cpuSupportsSSE2()) return matchLengthSSE2;
+#endif
+	return matchLengthScalar;
+}
+
+int matchLength(const unsigned char *a, const unsigned char *b, int max) {
+	static const MatchLengthFunction match_length = selectMatchLength();
+	return match_length(a, b, max);
+}
+
+// Compute the LCP array of data[0..length) with a virtual sentinel appended,
+// given its suffix array of length + 1 entries. longest_common_prefix[r] is the
+// length of the common prefix of the suffixes at suffix_array[r] and suffix_array[r + 1],
+// and longest_common_prefix[length] is 0.
+// plcp must have room for length + 1 ints. Its contents are overwritten.
+// The suffix and LCP arrays can be anything with operator[], such as int pointers.
+template <typename SuffixArray, typename LcpArray>
+void computeLongestCommonPrefix(const unsigned char *data, int length, SuffixArray suffix_array, int *plcp, LcpArray longest_common_prefix) {
+	// Store the suffix following each suffix in the suffix array in text order
+	for (int r = 0 ; r < length ; r++) {
+		plcp[suffix_array[r]] = suffix_array[r + 1];
+	}
+	plcp[suffix_array[length]] = length;
+
+	// Compute PLCP in text order. Each value is at most one less than the previous one.
+	int h = 0;
+	for (int i = 0 ; i < length ; i++) {
+		int j = plcp[i];
+		int m = length - std::max(i, j);
+		if (h < m && data[i + h] == data[j + h]) {
+			h += 1 + matchLength(&data[i + h + 1], &data[j + h + 1], m - h - 1);
+		}
+		plcp[i] = h;
+		if (h > 0) h = h - 1;
+	}
+	plcp[length] = 0;
+
+	// Permute into suffix array order
+	for (int r = 0 ; r <= length ; r++) {
+		longest_common_prefix[r] = plcp[suffix_array[r]];
+	}
+}
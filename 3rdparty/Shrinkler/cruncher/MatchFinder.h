@@ -16,31 +16,149 @@ before the matcher gives up finding more matches.
 The max_same_length parameter controls how many matches of the same length
 are reported. The matches reported will be the closest ones of that length.
 
+Alternatively, the matcher can use range indexes over the suffix array to
+jump straight to the nearest suffix in the reporting range. It then never
+gives up, as if match_patience was unlimited, and each step takes
+logarithmic time.
+
 */
 
 #pragma once
 
 #include <vector>
 #include <algorithm>
-#include <queue>
 #include <functional>
+#include <chrono>
+#include <mutex>
 
 using std::vector;
 
 #include "SuffixArray.h"
+#include "ParallelSuffixArray.h"
+#include "LongestCommonPrefix.h"
+#include "RangeIndex.h"
+
+// Suffix array entry, together with the length of the common prefix with the next entry.
+// The match finder reads both at the same index, so they are stored side by side.
+struct SuffixArrayEntry {
+	int pos;
+	int lcp;
+};
+
+// Array-like views of the positions and LCP values of suffix array entries
+template <typename Entry>
+struct SuffixPositions {
+	Entry *entries;
+
+	SuffixPositions(Entry *entries) : entries(entries) {}
+
+	auto& operator[](int r) const {
+		return entries[r].pos;
+	}
+};
+
+template <typename Entry>
+struct SuffixPrefixLengths {
+	Entry *entries;
+
+	SuffixPrefixLengths(Entry *entries) : entries(entries) {}
+
+	auto& operator[](int r) const {
+		return entries[r].lcp;
+	}
+};
+
+// Suffix array, reverse suffix array and longest common prefix array of a data block.
+// The index only depends on the data, not on any match finder parameters, and it is
+// never modified after construction. It can thus be shared between several match
+// finders working on the same data, including match finders running on other threads.
+class SuffixIndex {
+	void make_suffix_array() {
+		build_begin = std::chrono::steady_clock::now();
+		suffixes.resize(length + 1);
+		{
+			// Compute suffix array of the data with a virtual sentinel appended
+			vector<int> suffix_array(length + 1);
+			SuffixArrayWorkspace workspace;
+			workspace.reserve(suffixArrayWorkspaceSize(length + 1, 257));
+			computeSuffixArrayParallel(SentinelByteString(data, length), &suffix_array[0], length + 1, 257, num_threads, workspace);
+			for (int r = 0 ; r <= length ; r++) {
+				suffixes[r].pos = suffix_array[r];
+			}
+		}
+		suffix_array_end = std::chrono::steady_clock::now();
+
+		// Compute LCP array, using the reverse suffix array as temporary storage
+		rev_suffix_array.resize(length + 1);
+		computeLongestCommonPrefix(data, length, SuffixPositions<const SuffixArrayEntry>(&suffixes[0]), &rev_suffix_array[0], SuffixPrefixLengths<SuffixArrayEntry>(&suffixes[0]));
+
+		// Compute reverse suffix array
+		for (int r = 0 ; r <= length ; r++) {
+			rev_suffix_array[suffixes[r].pos] = r;
+		}
+		lcp_end = std::chrono::steady_clock::now();
+	}
+
+	// Built on first use, since only match finders using range indexes need it
+	mutable std::once_flag lcp_range_index_built;
+	mutable RangeMinIndex *lcp_range_index;
+
+	SuffixIndex(const SuffixIndex&);
+	SuffixIndex& operator=(const SuffixIndex&);
+
+public:
+	const unsigned char *data;
+	int length;
+	int num_threads;
+
+	vector<SuffixArrayEntry> suffixes;
+	vector<int> rev_suffix_array;
+
+	// When building the index began, and when the suffix array and the LCP array were done, for reporting
+	std::chrono::steady_clock::time_point build_begin;
+	std::chrono::steady_clock::time_point suffix_array_end;
+	std::chrono::steady_clock::time_point lcp_end;
+
+	SuffixIndex(const unsigned char *data, int length, int num_threads = 1) : data(data), length(length), num_threads(num_threads), lcp_range_index(NULL) {
+		make_suffix_array();
+	}
+
+	~SuffixIndex() {
+		delete lcp_range_index;
+	}
+
+	// Range minimum index over the LCP array. Like the rest of the index, it is
+	// shared by all match finders using it, and it may be requested from any thread.
+	const RangeMinIndex *lcpRangeIndex() const {
+		std::call_once(lcp_range_index_built, [this]() {
+			lcp_range_index = new RangeMinIndex(SuffixPrefixLengths<const SuffixArrayEntry>(&suffixes[0]), length + 1);
+		});
+		return lcp_range_index;
+	}
+};
+
+// Position index is rebuilt when skipping more than this fraction of the data
+#define MATCH_FINDER_REBUILD_FRACTION 16
 
 class MatchFinder {
+	// Index owned by this match finder, if not shared
+	const SuffixIndex *own_index;
+
 	// Inputs
-	unsigned char *data;
 	int length;
 	int min_length;
 	int match_patience;
 	int max_same_length;
 
 	// Suffix array
-	vector<int> suffix_array;
-	vector<int> rev_suffix_array;
-	vector<int> longest_common_prefix;
+	const SuffixArrayEntry *suffixes;
+	const int *rev_suffix_array;
+
+	// Range indexes, if used. The LCP index belongs to the suffix index.
+	// Positions below indexed_pos are in position_index.
+	const RangeMinIndex *lcp_index;
+	RangeMaxIndex *position_index;
+	int indexed_pos;
 
 	// Matcher parameters
 	int current_pos;
@@ -53,50 +171,44 @@ class MatchFinder {
 	int right_length;
 	int current_length;
 
-	// Best matches seen with current length
-	std::priority_queue<int, vector<int>, std::greater<int> > match_buffer;
-
-	void make_suffix_array() {
-		// Use reverse suffix array to store string as integers with sentinel
-		rev_suffix_array.resize(length + 1);
-		for (int i = 0; i < length ; i++) {
-			rev_suffix_array[i] = data[i] + 1;
-		}
-		rev_suffix_array[length] = 0;
-
-		// Compute suffix array
-		suffix_array.resize(length + 1);
-		computeSuffixArray(&rev_suffix_array[0], &suffix_array[0], length + 1, 257);
-
-		// Compute reverse suffix array
-		for (int i = 0 ; i <= length ; i++) {
-			rev_suffix_array[suffix_array[i]] = i;
-		}
+	// Best matches seen with current length. While filling, the buffer is
+	// a heap with the smallest position on top. While reporting, it is sorted.
+	vector<int> match_buffer;
+	int match_count;
+	int match_next;
 
-		// Compute LCP array
-		longest_common_prefix.resize(length + 1);
-		longest_common_prefix[0] = 0;
-		longest_common_prefix[length] = 0;
-		int h = 0;
-		for (int i = 0 ; i < length ; i++) {
-			int r = rev_suffix_array[i];
-			if (r < length) {
-				int j = suffix_array[r + 1];
-				int m = length - std::max(i, j);
-				while (h < m && data[i + h] == data[j + h]) {
-					h = h + 1;
-				}
-				longest_common_prefix[r] = h;
-				if (h > 0) h = h - 1;
-			}
+	// Replace the smallest position in the full match buffer heap
+	void replace_smallest_match(int match_pos) {
+		int *heap = &match_buffer[0];
+		int i = 0;
+		while (true) {
+			int child = 2 * i + 1;
+			if (child >= match_count) break;
+			if (child + 1 < match_count && heap[child + 1] < heap[child]) child++;
+			if (heap[child] >= match_pos) break;
+			heap[i] = heap[child];
+			i = child;
 		}
+		heap[i] = match_pos;
 	}
 
 	void extend_left() {
+		if (position_index != NULL) {
+			if (left_length < min_length) return;
+			int index = position_index->findLeft(left_index, min_pos);
+			if (index < 0) {
+				left_length = 0;
+				return;
+			}
+			left_length = std::min(left_length, lcp_index->min(index, left_index - 1));
+			left_index = index;
+			return;
+		}
 		int iter = 0;
 		while (left_length >= min_length) {
-			left_length = std::min(left_length, longest_common_prefix[--left_index]);
-			int pos = suffix_array[left_index];
+			const SuffixArrayEntry& entry = suffixes[--left_index];
+			left_length = std::min(left_length, entry.lcp);
+			int pos = entry.pos;
 			if (pos < current_pos && pos >= min_pos) break;
 			if (++iter > match_patience) {
 				left_length = 0;
@@ -106,11 +218,22 @@ class MatchFinder {
 	}
 
 	void extend_right() {
+		if (position_index != NULL) {
+			if (right_length < min_length) return;
+			int index = position_index->findRight(right_index, min_pos);
+			if (index < 0) {
+				right_length = 0;
+				return;
+			}
+			right_length = std::min(right_length, lcp_index->min(right_index, index - 1));
+			right_index = index;
+			return;
+		}
 		int iter = 0;
 		while (true) {
-			right_length = std::min(right_length, longest_common_prefix[right_index]);
+			right_length = std::min(right_length, suffixes[right_index].lcp);
 			if (right_length < min_length) break;
-			int pos = suffix_array[++right_index];
+			int pos = suffixes[++right_index].pos;
 			if (pos < current_pos && pos >= min_pos) break;
 			if (++iter > match_patience) {
 				right_length = 0;
@@ -123,13 +246,39 @@ class MatchFinder {
 		return std::max(left_length, right_length);
 	}
 
-public:
-	MatchFinder(unsigned char *data, int length, int min_length, int match_patience, int max_same_length) :
-		data(data), length(length), min_length(min_length), match_patience(match_patience), max_same_length(max_same_length) {
-		make_suffix_array();
+	MatchFinder(const SuffixIndex *index, bool owns_index, int min_length, int match_patience, int max_same_length, bool use_range_index) :
+		own_index(owns_index ? index : NULL), length(index->length), min_length(min_length), match_patience(match_patience), max_same_length(max_same_length),
+		suffixes(&index->suffixes[0]), rev_suffix_array(&index->rev_suffix_array[0]), match_buffer(max_same_length), match_count(0), match_next(0) {
+		lcp_index = NULL;
+		position_index = NULL;
+		indexed_pos = 0;
+		if (use_range_index) {
+			lcp_index = index->lcpRangeIndex();
+			position_index = new RangeMaxIndex(length + 1);
+		}
 		reset();
 	}
 
+	MatchFinder(const MatchFinder&);
+	MatchFinder& operator=(const MatchFinder&);
+
+public:
+	MatchFinder(const unsigned char *data, int length, int min_length, int match_patience, int max_same_length) :
+		MatchFinder(new SuffixIndex(data, length), true, min_length, match_patience, max_same_length, false) {
+	}
+
+	// Use an index which is shared with other match finders.
+	// The index must outlive the match finder.
+	// If use_range_index is true, match_patience is ignored.
+	MatchFinder(const SuffixIndex& index, int min_length, int match_patience, int max_same_length, bool use_range_index = false) :
+		MatchFinder(&index, false, min_length, match_patience, max_same_length, use_range_index) {
+	}
+
+	~MatchFinder() {
+		delete own_index;
+		delete position_index;
+	}
+
 	void reset() {
 	}
 
@@ -138,6 +287,24 @@ public:
 		current_pos = pos;
 		min_pos = 0;
 
+		if (position_index != NULL) {
+			// Make exactly the positions below pos available as matches.
+			// Adding positions one by one takes logarithmic time each, so when moving
+			// backwards or far ahead, such as at the start of a range of positions
+			// handled by one thread, rebuild the index from the suffix array instead.
+			if (pos < indexed_pos || pos - indexed_pos > length / MATCH_FINDER_REBUILD_FRACTION) {
+				position_index->assign([this, pos](int r) {
+					int p = suffixes[r].pos;
+					return p < pos ? p : -1;
+				}, length + 1);
+				indexed_pos = pos;
+			}
+			while (indexed_pos < pos) {
+				position_index->set(rev_suffix_array[indexed_pos], indexed_pos);
+				indexed_pos++;
+			}
+		}
+
 		left_index = rev_suffix_array[pos];
 		left_length = length - pos;
 		extend_left();
@@ -146,40 +313,51 @@ public:
 		extend_right();
 	}
 
+	// Length of the first (longest) match which nextMatch will report, or 0 if there is none.
+	// Must be called before nextMatch.
+	int longestMatchLength() {
+		int length = next_length();
+		return length >= min_length ? length : 0;
+	}
+
 	// Report next match. Returns whether a match was found.
 	bool nextMatch(int *match_pos_out, int *match_length_out) {
-		if (match_buffer.empty()) {
+		if (match_next == match_count) {
 			// Fill match buffer
 			current_length = next_length();
 			if (current_length < min_length) return false;
 			int new_min_pos = min_pos;
+			match_count = 0;
 			do {
 				int match_pos;
 				if (left_length > right_length) {
-					match_pos = suffix_array[left_index];
+					match_pos = suffixes[left_index].pos;
 					extend_left();
 				} else {
-					match_pos = suffix_array[right_index];
+					match_pos = suffixes[right_index].pos;
 					extend_right();
 				}
 				new_min_pos = std::max(new_min_pos, match_pos);
-				if (match_buffer.size() < max_same_length) {
-					match_buffer.push(match_pos);
+				if (match_count < max_same_length) {
+					match_buffer[match_count++] = match_pos;
+					std::push_heap(&match_buffer[0], &match_buffer[match_count], std::greater<int>());
 				} else {
-					if (match_pos > match_buffer.top()) {
-						match_buffer.pop();
-						match_buffer.push(match_pos);
+					if (match_pos > match_buffer[0]) {
+						replace_smallest_match(match_pos);
 					}
-					min_pos = match_buffer.top();
+					min_pos = match_buffer[0];
 				}
 			} while (next_length() == current_length);
-			assert(!match_buffer.empty());
+			assert(match_count > 0);
 			min_pos = new_min_pos;
+
+			// Report matches closest last
+			std::sort(&match_buffer[0], &match_buffer[match_count]);
+			match_next = 0;
 		}
 
 		*match_length_out = current_length;
-		*match_pos_out = match_buffer.top();
-		match_buffer.pop();
+		*match_pos_out = match_buffer[match_next++];
 		assert(*match_pos_out < current_pos);
 		return true;
 	}
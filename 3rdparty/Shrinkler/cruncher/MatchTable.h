@@ -0,0 +1,161 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Table of the matches reported by a MatchFinder for the positions of a data block.
+
+The matches reported for a position only depend on the suffix index and the
+match finder parameters, so they are the same in every parsing iteration.
+The table computes them once, on several threads, and stores them in
+compressed sparse row form: the matches of all positions in one array,
+plus the index of the first match of each position.
+
+The parser does not visit positions skipped by very long matches. To save
+time and memory, the table follows the same skipping rule and leaves these
+positions out. Whether the parser actually skips also depends on its state,
+so it may visit a position which is not in the table. It must then use a
+match finder for that position. The parse is the same either way.
+
+Building the table can be stopped. The table is then incomplete and must
+not be used.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <functional>
+
+using std::vector;
+
+#include "MatchFinder.h"
+#include "Parallel.h"
+
+// Number of positions processed by a thread at a time
+#define MATCH_TABLE_CHUNK_SIZE 4096
+
+class MatchTable {
+	vector<int> first;
+	vector<bool> present;
+	vector<int> positions;
+	vector<int> lengths;
+
+public:
+	// Whether building the table was stopped
+	bool interrupted;
+
+	// If given, stopped is called from all threads every MATCH_TABLE_CHUNK_SIZE positions,
+	// and must keep returning true once it has returned true.
+	MatchTable(const SuffixIndex& index, int min_length, int match_patience, int max_same_length, bool use_range_index, int skip_length, int num_threads,
+	           std::function<bool()> stopped = std::function<bool()>()) : interrupted(false) {
+		int length = index.length;
+		std::atomic<bool> stop(false);
+		auto check_stop = [&]() {
+			if (stopped && stopped()) stop = true;
+			return stop.load();
+		};
+
+		// Find longest match at each position
+		vector<int> longest(length + 1, 0);
+		parallelFor(num_threads, length + 1, [&](int t, int begin, int end) {
+			MatchFinder finder(index, min_length, match_patience, max_same_length, use_range_index);
+			for (int pos = std::max(begin, 1) ; pos < end ; pos++) {
+				if ((pos - begin) % MATCH_TABLE_CHUNK_SIZE == 0 && check_stop()) return;
+				finder.beginMatching(pos);
+				longest[pos] = std::min(finder.longestMatchLength(), length - pos);
+			}
+		});
+		if (stop) {
+			interrupted = true;
+			return;
+		}
+
+		// Find positions visited by the parser, assuming it skips after every long match
+		present.resize(length + 1, false);
+		vector<int>& visited = longest;
+		int visited_count = 0;
+		for (int pos = 1 ; pos <= length ; pos++) {
+			present[pos] = true;
+			int match_length = longest[pos];
+			visited[visited_count++] = pos;
+			if (match_length >= skip_length) {
+				pos += match_length - 1;
+			}
+		}
+
+		// Collect matches of visited positions, in chunks of consecutive positions
+		int num_chunks = (visited_count + MATCH_TABLE_CHUNK_SIZE - 1) / MATCH_TABLE_CHUNK_SIZE;
+		vector<vector<int> > chunk_positions(num_chunks);
+		vector<vector<int> > chunk_lengths(num_chunks);
+		vector<vector<int> > chunk_counts(num_chunks);
+		std::atomic<int> next_chunk(0);
+		parallelFor(num_threads, num_threads, [&](int t, int begin, int end) {
+			MatchFinder finder(index, min_length, match_patience, max_same_length, use_range_index);
+			for (int c = next_chunk++ ; c < num_chunks && !check_stop() ; c = next_chunk++) {
+				int chunk_end = std::min(visited_count, (c + 1) * MATCH_TABLE_CHUNK_SIZE);
+				for (int v = c * MATCH_TABLE_CHUNK_SIZE ; v < chunk_end ; v++) {
+					int count = 0;
+					int match_pos;
+					int match_length;
+					finder.beginMatching(visited[v]);
+					while (finder.nextMatch(&match_pos, &match_length)) {
+						chunk_positions[c].push_back(match_pos);
+						chunk_lengths[c].push_back(match_length);
+						count++;
+					}
+					chunk_counts[c].push_back(count);
+				}
+			}
+		});
+		if (stop) {
+			interrupted = true;
+			return;
+		}
+
+		// Concatenate chunks
+		first.resize(length + 2, 0);
+		int v = 0;
+		int total = 0;
+		for (int c = 0 ; c < num_chunks ; c++) {
+			positions.insert(positions.end(), chunk_positions[c].begin(), chunk_positions[c].end());
+			lengths.insert(lengths.end(), chunk_lengths[c].begin(), chunk_lengths[c].end());
+			vector<int>().swap(chunk_positions[c]);
+			vector<int>().swap(chunk_lengths[c]);
+			for (int i = 0 ; i < (int) chunk_counts[c].size() ; i++) {
+				int pos = visited[v++];
+				first[pos] = total;
+				total += chunk_counts[c][i];
+				first[pos + 1] = total;
+			}
+		}
+	}
+
+	// Whether the matches of the position are in the table
+	bool contains(int pos) const {
+		return present[pos];
+	}
+
+	// Matches of a position are the entries from begin(pos) until end(pos)
+	int begin(int pos) const {
+		return first[pos];
+	}
+
+	int end(int pos) const {
+		return first[pos + 1];
+	}
+
+	int matchPos(int i) const {
+		return positions[i];
+	}
+
+	int matchLength(int i) const {
+		return lengths[i];
+	}
+
+	int size() const {
+		return (int) positions.size();
+	}
+};
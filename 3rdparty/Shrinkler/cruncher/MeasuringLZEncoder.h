@@ -0,0 +1,112 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+LZ encoder which measures symbol sizes using tables, for use by the parser.
+
+The sizes given by a SizeMeasuringCoder do not change during a parsing
+pass. The encoder therefore looks up the size of each literal byte and of
+the symbol kind and repeated offset bits once when it is constructed, and
+takes number sizes directly from the number size cache of the coder.
+Pricing a literal or reference then only takes a few table loads.
+
+The sizes are the same as those given by a SpecializedLZEncoder for the
+SizeMeasuringCoder.
+
+*/
+
+#pragma once
+
+#include "LZEncoder.h"
+#include "SizeMeasuringCoder.h"
+
+template <bool PARITY_CONTEXT>
+class MeasuringLZEncoder : public LZEncoding {
+	SizeMeasuringCoder *coder;
+
+	// Indexed by parity (always 0 without parity context)
+	int kind_sizes[2][2];
+	int literal_sizes[2][256];
+	int repeated_sizes[2];
+
+	const unsigned short *offset_sizes;
+	int offset_sizes_count;
+	const unsigned short *length_sizes;
+	int length_sizes_count;
+
+	static int parityIndex(const LZState *state) {
+		return PARITY_CONTEXT ? state->parity & 1 : 0;
+	}
+
+	int offsetSize(int number) const {
+		if (number < offset_sizes_count) return offset_sizes[number];
+		return Coder::encodeNumber(coder, NUM_SINGLE_CONTEXTS + (CONTEXT_GROUP_OFFSET << 8), number);
+	}
+
+	int lengthSize(int number) const {
+		if (number < length_sizes_count) return length_sizes[number];
+		return Coder::encodeNumber(coder, NUM_SINGLE_CONTEXTS + (CONTEXT_GROUP_LENGTH << 8), number);
+	}
+
+public:
+	MeasuringLZEncoder(SizeMeasuringCoder *coder) : coder(coder) {
+		for (int parity = 0 ; parity < 2 ; parity++) {
+			int parity_offset = PARITY_CONTEXT ? parity << 8 : 0;
+			for (int kind = 0 ; kind < 2 ; kind++) {
+				kind_sizes[parity][kind] = coder->code(NUM_SINGLE_CONTEXTS + CONTEXT_KIND + parity_offset, kind);
+			}
+			for (int value = 0 ; value < 256 ; value++) {
+				int size = 0;
+				int context = 1;
+				for (int i = 7 ; i >= 0 ; i--) {
+					int bit = ((value >> i) & 1);
+					size += coder->code(NUM_SINGLE_CONTEXTS + (parity_offset | context), bit);
+					context = (context << 1) | bit;
+				}
+				literal_sizes[parity][value] = size;
+			}
+		}
+		for (int rep = 0 ; rep < 2 ; rep++) {
+			repeated_sizes[rep] = coder->code(NUM_SINGLE_CONTEXTS + CONTEXT_REPEATED, rep);
+		}
+		offset_sizes_count = coder->cachedNumberSizes(NUM_SINGLE_CONTEXTS + (CONTEXT_GROUP_OFFSET << 8), &offset_sizes);
+		length_sizes_count = coder->cachedNumberSizes(NUM_SINGLE_CONTEXTS + (CONTEXT_GROUP_LENGTH << 8), &length_sizes);
+	}
+
+	int encodeLiteral(unsigned char value, const LZState *state_before, LZState *state_after) const {
+		int parity = parityIndex(state_before);
+		int size = literal_sizes[parity][value];
+		if (state_before->after_first) {
+			size += kind_sizes[parity][KIND_LIT];
+		}
+		literalState(state_before, state_after);
+		return size;
+	}
+
+	int encodeReference(int offset, int length, const LZState *state_before, LZState *state_after) const {
+		assert(offset >= 1);
+		assert(length >= 2);
+		assert(state_before->after_first);
+
+		int size = kind_sizes[parityIndex(state_before)][KIND_REF];
+		int rep_offset = offset == state_before->last_offset;
+		if (!state_before->prev_was_ref) {
+			size += repeated_sizes[rep_offset];
+		} else {
+			assert(!rep_offset);
+		}
+		if (!rep_offset) {
+			size += offsetSize(offset + 2);
+		}
+		size += lengthSize(length);
+
+		referenceState(offset, length, state_before, state_after);
+		return size;
+	}
+
+	int finish(const LZState *state_before) const {
+		return SpecializedLZEncoder<SizeMeasuringCoder, PARITY_CONTEXT>(coder).finish(state_before);
+	}
+};
@@ -12,6 +12,7 @@ Pack a data block in multiple iterations, reporting progress along the way.
 #include "MatchFinder.h"
 #include "CountingCoder.h"
 #include "SizeMeasuringCoder.h"
+#include "MeasuringLZEncoder.h"
 #include "LZEncoder.h"
 #include "LZParser.h"
 
@@ -77,7 +78,9 @@ public:
 	}
 };
 
-void packData(unsigned char *data, int data_length, int zero_padding, PackParams *params, Coder *result_coder, RefEdgeFactory *edge_factory, bool show_progress) {
+// Pack using encoders specialized for each coder and the parity setting
+template <bool PARITY_CONTEXT>
+void packDataSpecialized(const unsigned char *data, int data_length, int zero_padding, PackParams *params, Coder *result_coder, RefEdgeFactory *edge_factory, bool show_progress) {
 	MatchFinder finder(data, data_length, 2, params->match_patience, params->max_same_length);
 	LZParser parser(data, data_length, zero_padding, finder, params->length_margin, params->skip_length, edge_factory);
 	result_size_t real_size = 0;
@@ -97,16 +100,15 @@ void packData(unsigned char *data, int data_length, int zero_padding, PackParams
 
 		// Parse data into LZ symbols
 		LZParseResult& result = results[1 - best_result];
-		Coder *measurer = new SizeMeasuringCoder(counting_coder);
+		SizeMeasuringCoder *measurer = new SizeMeasuringCoder(counting_coder);
 		measurer->setNumberContexts(LZEncoder::NUMBER_CONTEXT_OFFSET, LZEncoder::NUM_NUMBER_CONTEXTS, data_length);
 		finder.reset();
-		result = parser.parse(LZEncoder(measurer, params->parity_context), progress);
+		result = parser.parse(MeasuringLZEncoder<PARITY_CONTEXT>(measurer), progress);
 		delete measurer;
 
 		// Encode result using adaptive range coding
-		vector<unsigned> dummy_result;
-		RangeCoder *range_coder = new RangeCoder(LZEncoder::NUM_CONTEXTS, dummy_result);
-		real_size = result.encode(LZEncoder(range_coder, params->parity_context));
+		RangeCoder *range_coder = new RangeCoder(LZEncoder::NUM_CONTEXTS);
+		real_size = result.encode(SpecializedLZEncoder<RangeCoder, PARITY_CONTEXT>(range_coder));
 		range_coder->finish();
 		delete range_coder;
 
@@ -121,7 +123,7 @@ void packData(unsigned char *data, int data_length, int zero_padding, PackParams
 
 		// Count symbol frequencies
 		CountingCoder *new_counting_coder = new CountingCoder(LZEncoder::NUM_CONTEXTS);
-		result.encode(LZEncoder(counting_coder, params->parity_context));
+		result.encode(SpecializedLZEncoder<CountingCoder, PARITY_CONTEXT>(counting_coder));
 	
 		// New size measurer based on frequencies
 		CountingCoder *old_counting_coder = counting_coder;
@@ -132,5 +134,13 @@ void packData(unsigned char *data, int data_length, int zero_padding, PackParams
 	delete progress;
 	delete counting_coder;
 
-	results[best_result].encode(LZEncoder(result_coder, params->parity_context));
+	results[best_result].encode(SpecializedLZEncoder<Coder, PARITY_CONTEXT>(result_coder));
+}
+
+void packData(const unsigned char *data, int data_length, int zero_padding, PackParams *params, Coder *result_coder, RefEdgeFactory *edge_factory, bool show_progress) {
+	if (params->parity_context) {
+		packDataSpecialized<true>(data, data_length, zero_padding, params, result_coder, edge_factory, show_progress);
+	} else {
+		packDataSpecialized<false>(data, data_length, zero_padding, params, result_coder, edge_factory, show_progress);
+	}
 }
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Minimal helper for running loops on several threads.
+
+*/
+
+#pragma once
+
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using std::vector;
+
+// Split [0, length) into num_threads contiguous ranges and call
+// body(thread_index, begin, end) for each range, each on its own thread.
+// The calling thread processes the first range itself.
+// If body throws, all threads are still joined, and the first exception
+// is then rethrown on the calling thread.
+template <typename Body>
+void parallelFor(int num_threads, int length, Body body) {
+	if (num_threads > length) num_threads = length;
+	if (num_threads <= 1) {
+		body(0, 0, length);
+		return;
+	}
+	std::exception_ptr first_exception;
+	std::mutex exception_mutex;
+	auto run = [&](int t, int begin, int end) {
+		try {
+			body(t, begin, end);
+		} catch (...) {
+			std::lock_guard<std::mutex> lock(exception_mutex);
+			if (!first_exception) first_exception = std::current_exception();
+		}
+	};
+	vector<std::thread> threads;
+	try {
+		for (int t = 1 ; t < num_threads ; t++) {
+			int begin = (int) ((long long) length * t / num_threads);
+			int end = (int) ((long long) length * (t + 1) / num_threads);
+			threads.push_back(std::thread(run, t, begin, end));
+		}
+	} catch (...) {
+		// Could not start a thread. Its range is not processed, so the loop fails.
+		std::lock_guard<std::mutex> lock(exception_mutex);
+		if (!first_exception) first_exception = std::current_exception();
+	}
+	run(0, 0, (int) ((long long) length / num_threads));
+	for (int t = 0 ; t < (int) threads.size() ; t++) {
+		threads[t].join();
+	}
+	if (first_exception) std::rethrow_exception(first_exception);
+}
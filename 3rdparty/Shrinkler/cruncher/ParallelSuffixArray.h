@@ -0,0 +1,337 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Multi-threaded variant of the SA-IS suffix array construction in SuffixArray.h.
+
+The suffix array of a string is unique, so the result is identical to the one
+of computeSuffixArray. The following steps are run on several threads:
+
+- Classification of suffixes into S and L types, and counting of symbols.
+  Each thread classifies a range of the string. Runs of equal symbols at the
+  end of a range, whose type depends on the next range, are resolved afterwards.
+
+- Comparison of neighbouring LMS substrings when naming them.
+  Whether a substring differs from its predecessor is computed in parallel,
+  the names themselves are then assigned by a cheap sequential scan.
+
+- Inducing. Inducing scans the suffix array sequentially, and each step may
+  depend on the result of earlier steps. The scan is therefore split into
+  blocks. For each block, the threads first look up the symbol preceding each
+  suffix in the block. This is where the random memory accesses happen.
+  The sequential scan then only reads the looked up symbols and writes the
+  induced suffixes into the buckets. Should a suffix in the block be written
+  while the block is being scanned, its symbol is looked up on the spot.
+
+Small strings and small recursion levels are handled by computeSuffixArray,
+since for them the overhead of starting threads outweighs the gain.
+
+Suffix types and per-suffix flags are bit vectors, as in computeSuffixArray.
+Threads writing them work on ranges aligned to the 32 bit words of the vectors.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+using std::vector;
+using std::fill;
+using std::min;
+
+#include "SuffixArray.h"
+#include "Parallel.h"
+
+// Strings shorter than this are sorted sequentially
+#define PARALLEL_SA_MIN_LENGTH (1 << 15)
+
+// Number of suffix array entries per thread in each inducing block
+#define PARALLEL_SA_BLOCK_SIZE_PER_THREAD (1 << 15)
+
+// Like parallelFor, but with ranges aligned to the words of a BitVector of the given length
+template <typename Body>
+void parallelForWords(int num_threads, int length, Body body) {
+	parallelFor(num_threads, (int) BitVector::words(length), [&](int t, int word_begin, int word_end) {
+		body(t, word_begin * 32, min(length, word_end * 32));
+	});
+}
+
+// Compute suffix types. Returns the number of LMS suffixes.
+template <typename String>
+int computeSuffixTypesParallel(String data, int length, int alphabet_size, BitVector& stype, int *buckets, int num_threads) {
+	// Classify suffixes within each range. The type of a run of equal symbols
+	// at the end of a range depends on the following range.
+	vector<int> unknown_begin(num_threads, 0);
+	vector<int> range_end(num_threads, 0);
+	parallelForWords(num_threads, length, [&](int t, int begin, int end) {
+		int unknown = end;
+		bool is_s = false;
+		bool known = false;
+		int next_symbol = end < length ? data[end] : 0;
+		for (int i = end - 1 ; i >= begin ; i--) {
+			int symbol = data[i];
+			if (i == length - 1 || symbol < next_symbol) {
+				is_s = true;
+				known = true;
+			} else if (symbol > next_symbol) {
+				is_s = false;
+				known = true;
+			}
+			if (known) {
+				stype.set(i, is_s);
+			} else {
+				unknown = i;
+			}
+			next_symbol = symbol;
+		}
+		unknown_begin[t] = unknown;
+		range_end[t] = end;
+	});
+
+	// Resolve unknown types from right to left
+	for (int t = num_threads - 1 ; t >= 0 ; t--) {
+		if (unknown_begin[t] < range_end[t]) {
+			bool is_s = stype[range_end[t]];
+			for (int i = unknown_begin[t] ; i < range_end[t] ; i++) {
+				stype.set(i, is_s);
+			}
+		}
+	}
+
+	// Count symbols and LMS suffixes. Use per thread counts only if they do not take up too much memory.
+	bool local_counts = (long long) (alphabet_size + 1) * num_threads <= length;
+	vector<int> lms_counts(num_threads, 0);
+	vector<vector<int> > counts(local_counts ? num_threads : 0);
+	parallelFor(num_threads, length, [&](int t, int begin, int end) {
+		int lms_count = 0;
+		for (int i = begin ; i < end ; i++) {
+			if (IS_LMS(i)) lms_count++;
+		}
+		lms_counts[t] = lms_count;
+		if (local_counts) {
+			counts[t].resize(alphabet_size + 1, 0);
+			int *c = &counts[t][0];
+			for (int i = begin ; i < end ; i++) {
+				c[data[i]]++;
+			}
+		}
+	});
+	if (local_counts) {
+		for (int t = 0 ; t < num_threads ; t++) {
+			if (counts[t].empty()) continue;
+			for (int b = 0 ; b <= alphabet_size ; b++) {
+				buckets[b] += counts[t][b];
+			}
+		}
+	} else {
+		for (int i = 0 ; i < length ; i++) {
+			buckets[data[i]]++;
+		}
+	}
+
+	int lms_count = 0;
+	for (int t = 0 ; t < num_threads ; t++) {
+		lms_count += lms_counts[t];
+	}
+	return lms_count;
+}
+
+template <typename String>
+void induceParallel(String data, int *suffix_array, int length, int alphabet_size, const BitVector& stype, const int *buckets, int *bucket_index, int num_threads, SuffixArrayWorkspace& workspace) {
+	SuffixArrayWorkspace::Mark mark = workspace.mark();
+	int block_size = min(length, PARALLEL_SA_BLOCK_SIZE_PER_THREAD * num_threads);
+	int *cached_index = workspace.allocate(block_size);
+	int *cached_symbol = workspace.allocate(block_size);
+
+	// Look up the symbol preceding each suffix of a block, if that suffix has the given type.
+	auto lookup = [&](int block_start, int block_end, bool type) {
+		parallelFor(num_threads, block_end - block_start, [&](int t, int begin, int end) {
+			for (int k = begin ; k < end ; k++) {
+				int index = suffix_array[block_start + k];
+				cached_index[k] = index;
+				cached_symbol[k] = index > 0 && stype[index - 1] == type ? data[index - 1] : -1;
+			}
+		});
+	};
+
+	// Induce L suffixes
+	for (int b = 0 ; b < alphabet_size ; b++) {
+		bucket_index[b] = buckets[b];
+	}
+	for (int block_start = 0 ; block_start < length ; block_start += block_size) {
+		int block_end = min(length, block_start + block_size);
+		lookup(block_start, block_end, false);
+		for (int s = block_start ; s < block_end ; s++) {
+			int index = suffix_array[s];
+			int symbol = cached_symbol[s - block_start];
+			if (index != cached_index[s - block_start]) {
+				symbol = index > 0 && !stype[index - 1] ? data[index - 1] : -1;
+			}
+			if (symbol >= 0) {
+				suffix_array[bucket_index[symbol]++] = index - 1;
+			}
+		}
+	}
+
+	// Induce S suffixes
+	for (int b = 0 ; b < alphabet_size ; b++) {
+		bucket_index[b] = buckets[b + 1];
+	}
+	for (int block_end = length ; block_end > 0 ; block_end -= block_size) {
+		int block_start = std::max(0, block_end - block_size);
+		lookup(block_start, block_end, true);
+		for (int s = block_end - 1 ; s >= block_start ; s--) {
+			int index = suffix_array[s];
+			assert(index != UNINITIALIZED);
+			int symbol = cached_symbol[s - block_start];
+			if (index != cached_index[s - block_start]) {
+				symbol = index > 0 && stype[index - 1] ? data[index - 1] : -1;
+			}
+			if (symbol >= 0) {
+				suffix_array[--bucket_index[symbol]] = index - 1;
+			}
+		}
+	}
+
+	workspace.release(mark);
+}
+
+// Compute the suffix array of a string over an integer alphabet, using num_threads threads.
+// The last character in the string (the sentinel) must be uniquely smallest in the string.
+template <typename String>
+void computeSuffixArrayParallel(String data, int *suffix_array, int length, int alphabet_size, int num_threads, SuffixArrayWorkspace& workspace) {
+	if (num_threads <= 1 || length < PARALLEL_SA_MIN_LENGTH) {
+		computeSuffixArray(data, suffix_array, length, alphabet_size, workspace);
+		return;
+	}
+
+	SuffixArrayWorkspace::Mark mark = workspace.mark();
+	BitVector stype(workspace, length);
+	int *buckets = workspace.allocate(alphabet_size + 1);
+	int *bucket_index = workspace.allocate(alphabet_size);
+	fill(&buckets[0], &buckets[alphabet_size + 1], 0);
+
+	// Compute suffix types and count symbols
+	int lms_count = computeSuffixTypesParallel(data, length, alphabet_size, stype, buckets, num_threads);
+
+	// Accumulate bucket sizes
+	int l = 0;
+	for (int b = 0; b <= alphabet_size; b++) {
+		int l_next = l + buckets[b];
+		buckets[b] = l;
+		l = l_next;
+	}
+	assert(l == length);
+
+	// Put LMS suffixes at the ends of buckets
+	fill(&suffix_array[0], &suffix_array[length], UNINITIALIZED);
+	for (int b = 0 ; b < alphabet_size ; b++) {
+		bucket_index[b] = buckets[b + 1];
+	}
+	for (int i = length - 1; i >= 1; i--) {
+		if (IS_LMS(i)) {
+			suffix_array[--bucket_index[data[i]]] = i;
+		}
+	}
+
+	// Induce to sort LMS strings
+	induceParallel(data, suffix_array, length, alphabet_size, stype, buckets, bucket_index, num_threads, workspace);
+
+	// Compact LMS indices at the beginning of the suffix array
+	BitVector is_lms(workspace, length);
+	parallelForWords(num_threads, length, [&](int t, int begin, int end) {
+		for (int s = begin ; s < end ; s++) {
+			is_lms.set(s, IS_LMS(suffix_array[s]));
+		}
+	});
+	int j = 0;
+	for (int s = 0; s < length; s++) {
+		if (is_lms[s]) {
+			suffix_array[j++] = suffix_array[s];
+		}
+	}
+	assert(j == lms_count);
+
+	// Find LMS strings which differ from their predecessor
+	BitVector& differs = is_lms;
+	parallelForWords(num_threads, lms_count, [&](int t, int begin, int end) {
+		for (int s = std::max(begin, 1) ; s < end ; s++) {
+			differs.set(s, !substrings_equal(data, suffix_array[s - 1], suffix_array[s], stype));
+		}
+	});
+
+	// Name LMS strings, using the second half of the suffix array
+	int *sub_data = &suffix_array[length / 2];
+	int sub_capacity = length - length / 2;
+	fill(sub_data, &sub_data[sub_capacity], UNINITIALIZED);
+	int name = 0;
+	for (int s = 0; s < lms_count; s++) {
+		int index = suffix_array[s];
+		assert(index != UNINITIALIZED);
+		if (s > 0 && differs[s]) {
+			name += 1;
+		}
+		assert(sub_data[index / 2] == UNINITIALIZED);
+		sub_data[index / 2] = name;
+	}
+	int new_alphabet_size = name + 1;
+
+	if (new_alphabet_size != lms_count) {
+		// Order LMS strings using suffix array of named LMS symbols
+
+		// Compact named LMS symbols
+		j = 0;
+		for (int i = 0; i < sub_capacity; i++) {
+			int name = sub_data[i];
+			if (name != UNINITIALIZED) {
+				sub_data[j++] = name;
+			}
+		}
+		assert(j == lms_count);
+
+		// Sort named LMS symbols recursively
+		computeSuffixArrayParallel((const int *) sub_data, suffix_array, lms_count, new_alphabet_size, num_threads, workspace);
+
+		// Map named LMS symbol indices to LMS string indices in input string
+		j = 0;
+		for (int i = 1; i < length ; i++) {
+			if (IS_LMS(i)) {
+				sub_data[j++] = i;
+			}
+		}
+		assert(j == lms_count);
+		parallelFor(num_threads, lms_count, [&](int t, int begin, int end) {
+			for (int s = begin ; s < end ; s++) {
+				assert(suffix_array[s] < lms_count);
+				suffix_array[s] = sub_data[suffix_array[s]];
+			}
+		});
+	}
+
+	// Put LMS suffixes in sorted order at the ends of buckets
+	j = length;
+	int s = lms_count - 1;
+	for (int b = alphabet_size - 1; b >= 0; b--) {
+		while (s >= 0 && data[suffix_array[s]] == b) {
+			suffix_array[--j] = suffix_array[s--];
+		}
+		assert(j >= buckets[b]);
+		while (j > buckets[b]) {
+			suffix_array[--j] = UNINITIALIZED;
+		}
+	}
+
+	// Induce from sorted LMS strings to sort all suffixes
+	induceParallel(data, suffix_array, length, alphabet_size, stype, buckets, bucket_index, num_threads, workspace);
+
+	workspace.release(mark);
+}
+
+void computeSuffixArrayParallel(const int *data, int *suffix_array, int length, int alphabet_size, int num_threads) {
+	SuffixArrayWorkspace workspace;
+	workspace.reserve(suffixArrayWorkspaceSize(length, alphabet_size));
+	computeSuffixArrayParallel(data, suffix_array, length, alphabet_size, num_threads, workspace);
+}
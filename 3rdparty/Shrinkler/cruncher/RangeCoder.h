@@ -4,6 +4,13 @@
 
 An entropy coder based on range coding.
 
+Carries are added to the output a whole word at a time. A coder constructed
+without an output buffer only keeps track of the coded size, which is all
+that is needed when measuring the size of a parse.
+
+Coders share no mutable state, so different coders can be used on
+different threads at the same time.
+
 */
 
 #pragma once
@@ -22,42 +29,33 @@ using std::vector;
 #define ADJUST_SHIFT 4
 #endif
 
-class RangeCoder : public Coder {
+class RangeCoder final : public Coder {
 	vector<unsigned short> contexts;
+	vector<unsigned> no_output;
 	vector<unsigned>& out;
+	bool write_output;
 	int dest_bit;
 	unsigned intervalsize;
 	unsigned intervalmin;
 
-	static int sizetable[128];
-	static bool sizetable_init;
+	const int *sizetable;
 
-	static bool init_sizetable() {
-		for (int i = 0 ; i < 128 ; i++) {
-			sizetable[i] = (int) floor(0.5 + (8.0 - log((double) (128 + i)) / log(2.0)) * (1 << BIT_PRECISION));
-		}
-
-		return true;
-	}
+	// Table shared by all coders. It is computed on first use, which is safe from several threads.
+	static const int *sharedSizeTable() {
+		static const struct SizeTable {
+			int sizes[128];
 
-	void addBit() {
-		int pos = dest_bit;
-		int longpos;
-		int bitmask;
-		do {
-			pos--;
-			if (pos < 0) return;
-			longpos = pos >> 5;
-			bitmask = 0x80000000 >> (pos & 31);
-			while (longpos >= out.size()) {
-				out.push_back(0);
+			SizeTable() {
+				for (int i = 0 ; i < 128 ; i++) {
+					sizes[i] = (int) floor(0.5 + (8.0 - log((double) (128 + i)) / log(2.0)) * (1 << BIT_PRECISION));
+				}
 			}
-			out[longpos] ^= bitmask;
-		} while ((out[longpos] & bitmask) == 0);
+		} table;
+		return table.sizes;
 	}
 
-public:
-	RangeCoder(int n_contexts, vector<unsigned>& out) : out(out) {
+	void init(int n_contexts) {
+		sizetable = sharedSizeTable();
 		contexts.resize(n_contexts, 0x8000);
 		dest_bit = -1;
 		intervalsize = 0x8000;
@@ -65,6 +63,35 @@ public:
 		out.clear();
 	}
 
+	// Add one at the bit before dest_bit, propagating the carry into earlier bits
+	void addBit() {
+		if (!write_output) return;
+		int pos = dest_bit - 1;
+		if (pos < 0) return;
+		int longpos = pos >> 5;
+		if (longpos >= out.size()) {
+			out.resize(longpos + 1, 0);
+		}
+		unsigned old_word = out[longpos];
+		out[longpos] = old_word + (0x80000000 >> (pos & 31));
+		while (out[longpos] < old_word) {
+			// Carry out of the word
+			if (--longpos < 0) return;
+			old_word = out[longpos];
+			out[longpos] = old_word + 1;
+		}
+	}
+
+public:
+	RangeCoder(int n_contexts, vector<unsigned>& out) : out(out), write_output(true) {
+		init(n_contexts);
+	}
+
+	// Coder which only measures the coded size
+	RangeCoder(int n_contexts) : out(no_output), write_output(false) {
+		init(n_contexts);
+	}
+
 	virtual int code(int context_index, int bit) {
 		assert(context_index < contexts.size());
 		assert(bit == 0 || bit == 1);
@@ -119,8 +146,8 @@ public:
 			final_size >>= 1;
 		}
 
-		while ((dest_bit - 1) >> 5 >= out.size()) {
-			out.push_back(0);
+		if (write_output && (dest_bit - 1) >> 5 >= (int) out.size()) {
+			out.resize(((dest_bit - 1) >> 5) + 1, 0);
 		}
 	}
 
@@ -129,7 +156,3 @@ public:
 	}
 
 };
-
-
-int RangeCoder::sizetable[128];
-bool RangeCoder::sizetable_init = init_sizetable();
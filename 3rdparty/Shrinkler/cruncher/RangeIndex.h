@@ -0,0 +1,124 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Segment trees used by the match finder to search the suffix array in
+logarithmic time instead of walking it entry by entry.
+
+RangeMinIndex answers minimum queries over a fixed array, such as the
+LCP array. RangeMaxIndex holds values which can be updated, and finds
+the nearest entry to the left or right of an index whose value is at
+least a given threshold.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+
+using std::vector;
+
+// Number of leaves of a segment tree with at least the given number of entries
+int segmentTreeLeaves(int entries) {
+	int leaves = 1;
+	while (leaves < entries) leaves *= 2;
+	return leaves;
+}
+
+class RangeMinIndex {
+	int leaves;
+	vector<int> tree;
+
+public:
+	// Values can be anything with operator[]
+	template <typename Values>
+	RangeMinIndex(Values values, int count) {
+		leaves = segmentTreeLeaves(count);
+		tree.resize(2 * leaves, 0x7fffffff);
+		for (int i = 0 ; i < count ; i++) {
+			tree[leaves + i] = values[i];
+		}
+		for (int node = leaves - 1 ; node >= 1 ; node--) {
+			tree[node] = std::min(tree[2 * node], tree[2 * node + 1]);
+		}
+	}
+
+	// Minimum of the values at indices first to last, inclusive
+	int min(int first, int last) const {
+		int result = 0x7fffffff;
+		for (int l = first + leaves, r = last + leaves + 1 ; l < r ; l /= 2, r /= 2) {
+			if (l & 1) result = std::min(result, tree[l++]);
+			if (r & 1) result = std::min(result, tree[--r]);
+		}
+		return result;
+	}
+};
+
+class RangeMaxIndex {
+	int leaves;
+	vector<int> tree;
+
+	// Index of the leftmost (or rightmost) leaf below node with value at least threshold.
+	// The node value must be at least threshold.
+	int descend(int node, int threshold, bool rightmost) const {
+		while (node < leaves) {
+			int preferred = 2 * node + (rightmost ? 1 : 0);
+			node = tree[preferred] >= threshold ? preferred : preferred ^ 1;
+		}
+		return node - leaves;
+	}
+
+public:
+	// All values are initially -1
+	RangeMaxIndex(int entries) {
+		leaves = segmentTreeLeaves(entries + 1);
+		tree.resize(2 * leaves, -1);
+	}
+
+	void clear() {
+		std::fill(tree.begin(), tree.end(), -1);
+	}
+
+	// Set all values at once, in linear time. Values is a function from index to value.
+	template <typename Values>
+	void assign(Values values, int count) {
+		std::fill(tree.begin(), tree.end(), -1);
+		for (int i = 0 ; i < count ; i++) {
+			tree[leaves + i] = values(i);
+		}
+		for (int node = leaves - 1 ; node >= 1 ; node--) {
+			tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+		}
+	}
+
+	void set(int index, int value) {
+		int node = index + leaves;
+		tree[node] = value;
+		for (node /= 2 ; node >= 1 ; node /= 2) {
+			tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+		}
+	}
+
+	// Largest index below the given one with value at least threshold, or -1 if none
+	int findLeft(int index, int threshold) const {
+		for (int node = index + leaves ; node > 1 ; node /= 2) {
+			if ((node & 1) && tree[node - 1] >= threshold) {
+				return descend(node - 1, threshold, true);
+			}
+		}
+		return -1;
+	}
+
+	// Smallest index above the given one with value at least threshold, or -1 if none
+	int findRight(int index, int threshold) const {
+		for (int node = index + leaves ; node > 1 ; node /= 2) {
+			if (!(node & 1) && tree[node + 1] >= threshold) {
+				return descend(node + 1, threshold, false);
+			}
+		}
+		return -1;
+	}
+};
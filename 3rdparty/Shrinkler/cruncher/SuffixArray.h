@@ -4,6 +4,15 @@
 
 Suffix array construction based on the SA-IS algorithm.
 
+The construction works on any string type which returns integer symbols
+through operator[], such as a plain int array. The top level string does
+not need to be copied into an int array: SentinelByteString presents a
+byte buffer as symbols 1-256 followed by a virtual sentinel symbol 0.
+
+Suffix types are kept in bit vectors. These and the bucket arrays of all
+recursion levels are allocated from a SuffixArrayWorkspace, which hands out
+memory in a stack-like fashion and keeps it for reuse by later levels.
+
 */
 
 #pragma once
@@ -17,7 +26,93 @@ using std::fill;
 #define UNINITIALIZED (-1)
 #define IS_LMS(i) ((i) > 0 && stype[(i)] && !stype[(i) - 1])
 
-void induce(const int *data, int *suffix_array, int length, int alphabet_size, const vector<bool>& stype, const int *buckets, int *bucket_index) {
+// Byte string followed by a virtual sentinel.
+// Symbol i is data[i] + 1 for i < length, and 0 for i == length.
+struct SentinelByteString {
+	const unsigned char *data;
+	int length;
+
+	SentinelByteString(const unsigned char *data, int length) : data(data), length(length) {}
+
+	int operator[](int i) const {
+		return i < length ? data[i] + 1 : 0;
+	}
+};
+
+// Stack-like allocator for the temporary arrays of suffix array construction.
+// Memory is allocated in blocks which never move, so pointers remain valid
+// until released. Released memory is kept and reused by later allocations.
+class SuffixArrayWorkspace {
+	vector<vector<int> > blocks;
+	int block;
+	size_t used;
+
+public:
+	struct Mark {
+		int block;
+		size_t used;
+	};
+
+	SuffixArrayWorkspace() : block(0), used(0) {}
+
+	// Reserve a first block large enough for the given number of ints
+	void reserve(size_t size) {
+		if (blocks.empty()) {
+			blocks.push_back(vector<int>(size));
+		}
+	}
+
+	int *allocate(size_t size) {
+		while (block < (int) blocks.size() && used + size > blocks[block].size()) {
+			block++;
+			used = 0;
+		}
+		if (block == (int) blocks.size()) {
+			size_t block_size = blocks.empty() ? size : std::max(size, 2 * blocks.back().size());
+			blocks.push_back(vector<int>(block_size));
+		}
+		int *p = &blocks[block][used];
+		used += size;
+		return p;
+	}
+
+	Mark mark() const {
+		Mark m = { block, used };
+		return m;
+	}
+
+	void release(Mark m) {
+		block = m.block;
+		used = m.used;
+	}
+};
+
+// Bit vector packed into 32 bit words, used for suffix types (true for S, false for L).
+// Setting bits of different words from different threads is safe.
+class BitVector {
+	unsigned *bits;
+
+public:
+	static size_t words(int length) {
+		return (size_t) length / 32 + 1;
+	}
+
+	BitVector(SuffixArrayWorkspace& workspace, int length) {
+		bits = (unsigned *) workspace.allocate(words(length));
+	}
+
+	bool operator[](int i) const {
+		return (bits[i >> 5] >> (i & 31)) & 1;
+	}
+
+	void set(int i, bool value) {
+		unsigned mask = 1u << (i & 31);
+		bits[i >> 5] = value ? bits[i >> 5] | mask : bits[i >> 5] & ~mask;
+	}
+};
+
+template <typename String>
+void induce(String data, int *suffix_array, int length, int alphabet_size, const BitVector& stype, const int *buckets, int *bucket_index) {
 	// Induce L suffixes
 	for (int b = 0 ; b < alphabet_size ; b++) {
 		bucket_index[b] = buckets[b];
@@ -41,7 +136,8 @@ void induce(const int *data, int *suffix_array, int length, int alphabet_size, c
 	}
 }
 
-bool substrings_equal(const int *data, int i1, int i2, const vector<bool>& stype) {
+template <typename String>
+bool substrings_equal(String data, int i1, int i2, const BitVector& stype) {
 	while (data[i1++] == data[i2++]) {
 		if (IS_LMS(i1) && IS_LMS(i2)) return true;
 	}
@@ -50,7 +146,8 @@ bool substrings_equal(const int *data, int i1, int i2, const vector<bool>& stype
 
 // Compute the suffix array of a string over an integer alphabet.
 // The last character in the string (the sentinel) must be uniquely smallest in the string.
-void computeSuffixArray(const int *data, int *suffix_array, int length, int alphabet_size) {
+template <typename String>
+void computeSuffixArray(String data, int *suffix_array, int length, int alphabet_size, SuffixArrayWorkspace& workspace) {
 	// Handle empty string
 	assert(length >= 1);
 	if (length == 1) {
@@ -58,24 +155,29 @@ void computeSuffixArray(const int *data, int *suffix_array, int length, int alph
 		return;
 	}
 
-	vector<bool> stype(length);
-	vector<int> buckets(alphabet_size + 1, 0);
-	vector<int> bucket_index(alphabet_size);
+	SuffixArrayWorkspace::Mark mark = workspace.mark();
+	BitVector stype(workspace, length);
+	int *buckets = workspace.allocate(alphabet_size + 1);
+	int *bucket_index = workspace.allocate(alphabet_size);
+	fill(&buckets[0], &buckets[alphabet_size + 1], 0);
 
 	// Compute suffix types and count symbols
-	stype[length - 1] = true;
+	stype.set(length - 1, true);
 	buckets[data[length - 1]] = 1;
 	bool is_s = true;
 	int lms_count = 0;
+	int next_symbol = data[length - 1];
 	for (int i = length - 2; i >= 0; i--) {
-		buckets[data[i]]++;
-		if (data[i] > data[i + 1]) {
+		int symbol = data[i];
+		buckets[symbol]++;
+		if (symbol > next_symbol) {
 			if (is_s) lms_count++;
 			is_s = false;
-		} else if (data[i] < data[i + 1]) {
+		} else if (symbol < next_symbol) {
 			is_s = true;
 		}
-		stype[i] = is_s;
+		stype.set(i, is_s);
+		next_symbol = symbol;
 	}
 
 	// Accumulate bucket sizes
@@ -99,7 +201,7 @@ void computeSuffixArray(const int *data, int *suffix_array, int length, int alph
 	}
 
 	// Induce to sort LMS strings
-	induce(data, suffix_array, length, alphabet_size, stype, &buckets[0], &bucket_index[0]);
+	induce(data, suffix_array, length, alphabet_size, stype, buckets, bucket_index);
 
 	// Compact LMS indices at the beginning of the suffix array
 	int j = 0;
@@ -143,7 +245,7 @@ void computeSuffixArray(const int *data, int *suffix_array, int length, int alph
 		assert(j == lms_count);
 
 		// Sort named LMS symbols recursively
-		computeSuffixArray(sub_data, suffix_array, lms_count, new_alphabet_size);
+		computeSuffixArray((const int *) sub_data, suffix_array, lms_count, new_alphabet_size, workspace);
 
 		// Map named LMS symbol indices to LMS string indices in input string
 		j = 0;
@@ -173,5 +275,19 @@ void computeSuffixArray(const int *data, int *suffix_array, int length, int alph
 	}
 
 	// Induce from sorted LMS strings to sort all suffixes
-	induce(data, suffix_array, length, alphabet_size, stype, &buckets[0], &bucket_index[0]);
+	induce(data, suffix_array, length, alphabet_size, stype, buckets, bucket_index);
+
+	workspace.release(mark);
+}
+
+// Size in ints of the workspace needed by the top level of computeSuffixArray.
+// Recursion levels work on at most half the length and get additional blocks if needed.
+size_t suffixArrayWorkspaceSize(int length, int alphabet_size) {
+	return BitVector::words(length) + 2 * alphabet_size + 1;
+}
+
+void computeSuffixArray(const int *data, int *suffix_array, int length, int alphabet_size) {
+	SuffixArrayWorkspace workspace;
+	workspace.reserve(suffixArrayWorkspaceSize(length, alphabet_size));
+	computeSuffixArray(data, suffix_array, length, alphabet_size, workspace);
 }
@@ -0,0 +1,231 @@
+// SPDX-FileCopyrightText: 1999-present Aske Simon Christensen
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: LicenseRef-Shrinkler
+
+/*
+
+Open addressing hash map from integers, in the style of the Swiss table.
+Used for mapping offsets to the best edges in the LZ parser.
+
+The slots are divided into groups of 16. Each slot has a control byte
+holding 7 bits of the hash of its key, or a marker for an empty or deleted
+slot. A lookup compares the control bytes of a whole group at once and
+only looks at the keys of the slots with matching hash bits. Probing moves
+on to the next group until the key is found or the group has an empty slot.
+
+The slots only hold the keys and the indices of the entries. The keys and
+values of the entries are kept densely in insertion order, with the last
+entry moved into the place of an erased one, so iterating over the map
+does not need to skip empty slots.
+
+*/
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+using std::vector;
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SWISS_HASH_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "BitUtils.h"
+#include "assert.h"
+
+#define SWISS_HASH_GROUP_SIZE 16
+
+template <typename V>
+class SwissHash {
+	static constexpr signed char EMPTY = -128;
+	static constexpr signed char DELETED = -2;
+
+	struct Slot {
+		int key;
+		int entry;
+	};
+
+	vector<signed char> control;
+	vector<Slot> slots;
+	int group_mask;
+	int group_shift;
+	int tombstones;
+
+	vector<int> keys;
+	vector<V> values;
+
+	static uint64_t hash(int key) {
+		return (uint64_t) (unsigned) key * 0x9E3779B97F4A7C15ull;
+	}
+
+	// The high bits of a multiplicative hash depend on all bits of the key,
+	// so they select the first group. Bits 25 to 31 are kept in the control byte.
+	int firstGroup(uint64_t hash) const {
+		return (int) (hash >> group_shift) & group_mask;
+	}
+
+	static signed char tag(uint64_t hash) {
+		return (signed char) ((uint32_t) hash >> 25);
+	}
+
+	// Bit mask of the slots in a group with the given control byte
+	static unsigned matchControl(const signed char *group, signed char c) {
+#ifdef SWISS_HASH_SSE2
+		__m128i g = _mm_loadu_si128((const __m128i *) group);
+		return (unsigned) _mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(c)));
+#else
+		unsigned mask = 0;
+		for (int i = 0 ; i < SWISS_HASH_GROUP_SIZE ; i++) {
+			if (group[i] == c) mask |= 1u << i;
+		}
+		return mask;
+#endif
+	}
+
+	// Bit mask of the empty or deleted slots in a group
+	static unsigned matchFree(const signed char *group) {
+#ifdef SWISS_HASH_SSE2
+		return (unsigned) _mm_movemask_epi8(_mm_loadu_si128((const __m128i *) group));
+#else
+		unsigned mask = 0;
+		for (int i = 0 ; i < SWISS_HASH_GROUP_SIZE ; i++) {
+			if (group[i] < 0) mask |= 1u << i;
+		}
+		return mask;
+#endif
+	}
+
+	int capacity() const {
+		return (int) control.size();
+	}
+
+	// Slot holding the key, or -1 if none
+	int findSlot(int key) const {
+		uint64_t h = hash(key);
+		signed char t = tag(h);
+		int group = firstGroup(h);
+		for (int step = 1 ; ; step++) {
+			const signed char *group_control = &control[group * SWISS_HASH_GROUP_SIZE];
+			for (unsigned mask = matchControl(group_control, t) ; mask != 0 ; mask &= mask - 1) {
+				int slot = group * SWISS_HASH_GROUP_SIZE + lowestSetBit(mask);
+				if (slots[slot].key == key) return slot;
+			}
+			if (matchControl(group_control, EMPTY) != 0) return -1;
+			group = (group + step) & group_mask;
+		}
+	}
+
+	// Put a key which is not in the map into a free slot
+	void placeKey(int key, int entry) {
+		uint64_t h = hash(key);
+		int group = firstGroup(h);
+		for (int step = 1 ; ; step++) {
+			unsigned mask = matchFree(&control[group * SWISS_HASH_GROUP_SIZE]);
+			if (mask != 0) {
+				int slot = group * SWISS_HASH_GROUP_SIZE + lowestSetBit(mask);
+				if (control[slot] == DELETED) tombstones--;
+				control[slot] = tag(h);
+				slots[slot].key = key;
+				slots[slot].entry = entry;
+				return;
+			}
+			group = (group + step) & group_mask;
+		}
+	}
+
+	void rehash(int groups) {
+		control.assign(groups * SWISS_HASH_GROUP_SIZE, EMPTY);
+		slots.resize(groups * SWISS_HASH_GROUP_SIZE);
+		group_mask = groups - 1;
+		// Shifting a 64-bit value by 64 is undefined, so a single group uses bit 63
+		group_shift = 63;
+		while ((1 << (64 - group_shift)) <= group_mask) group_shift--;
+		tombstones = 0;
+		for (int i = 0 ; i < size() ; i++) {
+			placeKey(keys[i], i);
+		}
+	}
+
+public:
+	SwissHash() {
+		rehash(1);
+	}
+
+	int size() const {
+		return (int) keys.size();
+	}
+
+	bool empty() const {
+		return keys.empty();
+	}
+
+	// Entries are numbered from 0 to size() - 1
+	int key(int i) const {
+		return keys[i];
+	}
+
+	V& value(int i) {
+		return values[i];
+	}
+
+	// Value of a key, or NULL if the key is not in the map
+	V* find(int key) {
+		int slot = findSlot(key);
+		return slot < 0 ? NULL : &values[slots[slot].entry];
+	}
+
+	int count(int key) const {
+		return findSlot(key) < 0 ? 0 : 1;
+	}
+
+	V& operator[](int key) {
+		V* value = find(key);
+		if (value != NULL) return *value;
+
+		// Keep at least one eighth of the slots empty
+		if ((size() + tombstones + 1) * 8 > capacity() * 7) {
+			int groups = group_mask + 1;
+			rehash((size() + 1) * 16 > capacity() * 7 ? groups * 2 : groups);
+		}
+		placeKey(key, size());
+		keys.push_back(key);
+		values.push_back(V());
+		return values.back();
+	}
+
+	void erase(int key) {
+		int slot = findSlot(key);
+		if (slot < 0) return;
+		int entry = slots[slot].entry;
+
+		// Probing stops at a group with an empty slot, so the slot can become empty
+		// unless the group is full
+		int group = slot / SWISS_HASH_GROUP_SIZE;
+		if (matchControl(&control[group * SWISS_HASH_GROUP_SIZE], EMPTY) != 0) {
+			control[slot] = EMPTY;
+		} else {
+			control[slot] = DELETED;
+			tombstones++;
+		}
+
+		// Move the last entry into the place of the erased one
+		int last = size() - 1;
+		if (entry != last) {
+			keys[entry] = keys[last];
+			values[entry] = values[last];
+			slots[findSlot(keys[entry])].entry = entry;
+		}
+		keys.pop_back();
+		values.pop_back();
+	}
+
+	void clear() {
+		std::fill(control.begin(), control.end(), EMPTY);
+		tombstones = 0;
+		keys.clear();
+		values.clear();
+	}
+};
@@ -5,6 +5,7 @@
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include "shrinklergbacore/batch_packer.hpp"
 #include "shrinklergbacore/command_line.hpp"
 #include "shrinklergbacore/gba_packer.hpp"
 #include "shrinklergbacore/options.hpp"
@@ -13,8 +14,16 @@ using namespace shrinklergbacore;
 
 static void process(const options& options)
 {
-    gba_packer packer;
-    packer.pack(options);
+    if (!options.batch_file().empty())
+    {
+        batch_packer packer;
+        packer.pack(options);
+    }
+    else
+    {
+        gba_packer packer;
+        packer.pack(options);
+    }
 }
 
 int main(int argc, char* argv[])
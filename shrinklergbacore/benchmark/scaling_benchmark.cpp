@@ -0,0 +1,362 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+// End-to-end scaling benchmark: packs a synthetic corpus with the full gba_packer pipeline
+// for each combination of input, preset and number of references (-r), and records
+// wall time, CPU time, peak memory and cart size.
+//
+// Usage: shrinkler_gba_scaling [options]
+//   --corpus=DIR           Directory for the corpus and the carts. Default: a directory in the temp directory.
+//   --generate-only        Only write the corpus, e.g. to pack it with other tools.
+//   --kinds=LIST           Kinds of inputs. Default: code,table,padded
+//   --sizes=LIST           Input sizes in KB. Default: 1,4,16,64,256
+//   --presets=LIST         Presets. Default: 1,3,5,9
+//   --references=LIST      Numbers of references. Default: 1000,10000,100000
+//   --threads=N            Threads used by each run. Default: 1, so that CPU time and wall time are comparable.
+//   --format=csv|json      Output format. Default: csv
+// Lists are comma separated. Results are written to stdout, progress to stderr.
+//
+// On POSIX systems each run is done in a child process, so that its peak memory can be measured.
+// Elsewhere the runs are done in this process, and CPU time and peak memory are not available.
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "shrinklergbacore/console.hpp"
+#include "shrinklergbacore/gba_packer.hpp"
+#include "shrinklergbacore/options.hpp"
+#include "synthetic_corpus.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define SHRINKLER_GBA_SCALING_FORK 1
+#endif
+
+namespace
+{
+
+using shrinklergbacore_benchmark::corpus_entry;
+using shrinklergbacore_benchmark::corpus_kind;
+using std::string;
+using std::vector;
+
+struct scaling_options
+{
+    std::filesystem::path corpus_directory = std::filesystem::temp_directory_path() / "shrinkler_gba_scaling";
+    bool generate_only = false;
+    vector<corpus_kind> kinds = { corpus_kind::code, corpus_kind::table, corpus_kind::padded };
+    vector<size_t> sizes = { 1024, 4 * 1024, 16 * 1024, 64 * 1024, 256 * 1024 };
+    vector<int> presets = { 1, 3, 5, 9 };
+    vector<int> references = { 1000, 10000, 100000 };
+    unsigned int threads = 1;
+    bool json = false;
+};
+
+struct run_result
+{
+    size_t output_size = 0;
+    double wall_seconds = 0;
+    std::optional<double> cpu_seconds;
+    std::optional<long> peak_rss_kb;
+};
+
+vector<string> split_list(std::string_view list)
+{
+    vector<string> items;
+    size_t begin = 0;
+    while (begin <= list.size())
+    {
+        auto end = list.find(',', begin);
+        if (end == std::string_view::npos)
+        {
+            end = list.size();
+        }
+        items.emplace_back(list.substr(begin, end - begin));
+        begin = end + 1;
+    }
+    return items;
+}
+
+int parse_int(const string& s)
+{
+    size_t end = 0;
+    int value = 0;
+    try
+    {
+        value = std::stoi(s, &end);
+    }
+    catch (const std::exception&)
+    {
+        end = 0;
+    }
+    if ((end == 0) || (end != s.size()) || (value <= 0))
+    {
+        throw std::runtime_error(std::format("invalid number '{}'", s));
+    }
+    return value;
+}
+
+scaling_options parse_arguments(int argc, char* argv[])
+{
+    scaling_options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument(argv[i]);
+        const auto equals = argument.find('=');
+        const auto name = argument.substr(0, equals);
+        const auto value = equals == std::string_view::npos ? std::string_view() : argument.substr(equals + 1);
+
+        if (name == "--corpus")
+        {
+            options.corpus_directory = value;
+        }
+        else if (argument == "--generate-only")
+        {
+            options.generate_only = true;
+        }
+        else if (name == "--kinds")
+        {
+            options.kinds.clear();
+            for (const auto& kind : split_list(value))
+            {
+                options.kinds.push_back(shrinklergbacore_benchmark::parse_corpus_kind(kind));
+            }
+        }
+        else if (name == "--sizes")
+        {
+            options.sizes.clear();
+            for (const auto& size : split_list(value))
+            {
+                options.sizes.push_back(static_cast<size_t>(parse_int(size)) * 1024);
+            }
+        }
+        else if (name == "--presets")
+        {
+            options.presets.clear();
+            for (const auto& preset : split_list(value))
+            {
+                options.presets.push_back(parse_int(preset));
+            }
+        }
+        else if (name == "--references")
+        {
+            options.references.clear();
+            for (const auto& references : split_list(value))
+            {
+                options.references.push_back(parse_int(references));
+            }
+        }
+        else if (name == "--threads")
+        {
+            options.threads = static_cast<unsigned int>(parse_int(string(value)));
+        }
+        else if ((name == "--format") && ((value == "csv") || (value == "json")))
+        {
+            options.json = value == "json";
+        }
+        else
+        {
+            throw std::runtime_error(std::format("invalid argument '{}'", argument));
+        }
+    }
+    return options;
+}
+
+shrinklergbacore::options make_packer_options(const corpus_entry& entry, const std::filesystem::path& output_file, int preset, int references, unsigned int threads)
+{
+    shrinklergbacore::options options;
+    options.input_file(entry.path);
+    options.output_file(output_file);
+    options.jobs(threads);
+    options.shrinkler_parameters().preset(preset);
+    options.shrinkler_parameters().references = references;
+    return options;
+}
+
+size_t pack(const shrinklergbacore::options& options)
+{
+    shrinklergbacore::console console;
+    console.out(nullptr);
+    console.warn(nullptr);
+    console.verbose(nullptr);
+    shrinklergbacore::gba_packer packer;
+    return packer.pack(options, console);
+}
+
+#if defined(SHRINKLER_GBA_SCALING_FORK)
+
+double to_seconds(const timeval& t)
+{
+    return static_cast<double>(t.tv_sec) + static_cast<double>(t.tv_usec) / 1e6;
+}
+
+run_result run(const shrinklergbacore::options& options)
+{
+    std::cout.flush();
+    std::cerr.flush();
+
+    const auto start = std::chrono::steady_clock::now();
+    const pid_t pid = fork();
+    if (pid < 0)
+    {
+        throw std::runtime_error("Could not start child process");
+    }
+    if (pid == 0)
+    {
+        // Leave with _exit, so that the parent's buffered output is not written a second time.
+        int status = EXIT_SUCCESS;
+        try
+        {
+            pack(options);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << e.what() << std::endl;
+            status = EXIT_FAILURE;
+        }
+        _exit(status);
+    }
+
+    int status = 0;
+    rusage usage{};
+    if (wait4(pid, &status, 0, &usage) != pid)
+    {
+        throw std::runtime_error("Could not wait for child process");
+    }
+    const std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    if (!WIFEXITED(status) || (WEXITSTATUS(status) != EXIT_SUCCESS))
+    {
+        throw std::runtime_error(std::format("Could not pack {}", options.input_file().string()));
+    }
+
+    run_result result;
+    result.output_size = std::filesystem::file_size(options.output_file());
+    result.wall_seconds = wall.count();
+    result.cpu_seconds = to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime);
+#if defined(__APPLE__)
+    result.peak_rss_kb = usage.ru_maxrss / 1024;
+#else
+    result.peak_rss_kb = usage.ru_maxrss;
+#endif
+    return result;
+}
+
+#else
+
+run_result run(const shrinklergbacore::options& options)
+{
+    const auto start = std::chrono::steady_clock::now();
+    run_result result;
+    result.output_size = pack(options);
+    result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+#endif
+
+template <typename T>
+string to_string_or(const std::optional<T>& value, const char* missing)
+{
+    return value ? std::format("{}", *value) : missing;
+}
+
+class result_writer final
+{
+public:
+    explicit result_writer(bool json) : m_json(json) {}
+
+    void begin()
+    {
+        if (m_json)
+        {
+            std::cout << "[" << std::endl;
+        }
+        else
+        {
+            std::cout << "corpus,kind,input_size,preset,references,output_size,wall_seconds,cpu_seconds,peak_rss_kb" << std::endl;
+        }
+    }
+
+    void write(const corpus_entry& entry, int preset, int references, const run_result& result)
+    {
+        if (m_json)
+        {
+            std::cout << std::format(
+                "{}  {{\"corpus\": \"{}\", \"kind\": \"{}\", \"input_size\": {}, \"preset\": {}, \"references\": {}, "
+                "\"output_size\": {}, \"wall_seconds\": {:.6f}, \"cpu_seconds\": {}, \"peak_rss_kb\": {}}}",
+                m_count ? ",\n" : "", entry.name, to_string(entry.kind), entry.size, preset, references,
+                result.output_size, result.wall_seconds, to_string_or(result.cpu_seconds, "null"), to_string_or(result.peak_rss_kb, "null"));
+        }
+        else
+        {
+            std::cout << std::format(
+                "{},{},{},{},{},{},{:.6f},{},{}",
+                entry.name, to_string(entry.kind), entry.size, preset, references,
+                result.output_size, result.wall_seconds, to_string_or(result.cpu_seconds, ""), to_string_or(result.peak_rss_kb, "")) << std::endl;
+        }
+        ++m_count;
+    }
+
+    void end()
+    {
+        if (m_json)
+        {
+            std::cout << (m_count ? "\n" : "") << "]" << std::endl;
+        }
+    }
+
+private:
+    bool m_json;
+    size_t m_count = 0;
+};
+
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const auto options = parse_arguments(argc, argv);
+        const auto corpus = shrinklergbacore_benchmark::write_corpus(options.corpus_directory, options.kinds, options.sizes);
+        std::cerr << std::format("Wrote {} files to {}", corpus.size(), options.corpus_directory.string()) << std::endl;
+        if (options.generate_only)
+        {
+            return EXIT_SUCCESS;
+        }
+
+        result_writer writer(options.json);
+        writer.begin();
+        for (const auto& entry : corpus)
+        {
+            for (auto preset : options.presets)
+            {
+                for (auto references : options.references)
+                {
+                    std::cerr << std::format("{} -p{} -r{}", entry.name, preset, references) << std::endl;
+                    const auto output_file = options.corpus_directory / std::format("{}-p{}-r{}.gba", entry.name, preset, references);
+                    const auto result = run(make_packer_options(entry, output_file, preset, references, options.threads));
+                    writer.write(entry, preset, references, result);
+                }
+            }
+        }
+        writer.end();
+
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
@@ -0,0 +1,461 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <algorithm>
+#include <array>
+#include <format>
+#include <stdexcept>
+#include "shrinklergbacore/elfio_wrapper.hpp"
+#include "synthetic_corpus.hpp"
+
+namespace shrinklergbacore_benchmark
+{
+
+using std::vector;
+
+namespace
+{
+
+// xorshift32. Not using the standard library's distributions, since their results differ between implementations.
+class random_generator final
+{
+public:
+    explicit random_generator(uint32_t seed) : m_state(seed ? seed : 1) {}
+
+    uint32_t next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    uint32_t below(uint32_t n) { return next() % n; }
+
+    // Small values are much more likely than large ones, like register numbers and offsets in compiled code.
+    uint32_t skewed(uint32_t n) { return std::min(below(n), below(n)); }
+
+private:
+    uint32_t m_state;
+};
+
+class image_writer final
+{
+public:
+    explicit image_writer(vector<unsigned char>& data) : m_data(data) {}
+
+    size_t size() const { return m_data.size(); }
+
+    void put8(uint32_t value)
+    {
+        m_data.push_back(static_cast<unsigned char>(value));
+    }
+
+    void put16(uint32_t value)
+    {
+        put8(value);
+        put8(value >> 8);
+    }
+
+    void put32(uint32_t value)
+    {
+        put16(value);
+        put16(value >> 16);
+    }
+
+    void align(size_t alignment)
+    {
+        while (m_data.size() % alignment)
+        {
+            put8(0);
+        }
+    }
+
+    void repeat(size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            m_data.push_back(m_data[i]);
+        }
+    }
+
+private:
+    vector<unsigned char>& m_data;
+};
+
+uint32_t make_literal(random_generator& random, size_t image_size)
+{
+    switch (random.below(4))
+    {
+        case 0: return 0x04000000 + (random.skewed(0x200) & ~1u);                                  // I/O register
+        case 1: return 0x06000000 + (random.skewed(0x18000) & ~3u);                                // VRAM
+        case 2: return corpus_load_address + (random.below(static_cast<uint32_t>(image_size) + 1) & ~3u); // Data or function
+        default: return random.skewed(0x10000);                                                     // Constant
+    }
+}
+
+// ARM startup code: data processing, loads and stores, and calls.
+void write_arm_code(image_writer& out, random_generator& random, size_t end)
+{
+    while (out.size() + 4 <= end)
+    {
+        const uint32_t rn = random.skewed(13);
+        const uint32_t rd = random.skewed(13);
+        switch (random.below(4))
+        {
+            case 0:
+            case 1:
+                out.put32(0xe0000000 | (random.below(16) << 21) | (random.below(2) << 20) | (rn << 16) | (rd << 12) | random.skewed(0x100) | (random.below(2) << 25));
+                break;
+            case 2:
+                out.put32(0xe5000000 | (random.below(2) << 20) | (1 << 23) | (rn << 16) | (rd << 12) | (random.skewed(64) * 4));
+                break;
+            default:
+                out.put32(0xeb000000 | (random.next() & 0xffffff));
+                break;
+        }
+    }
+}
+
+void write_thumb_instruction(image_writer& out, random_generator& random, vector<uint32_t>& pool, const vector<size_t>& functions)
+{
+    const uint32_t rd = random.skewed(8);
+    const uint32_t rn = random.skewed(8);
+    switch (random.below(16))
+    {
+        case 0:
+        case 1:
+        case 2:
+            // mov, cmp, add, sub immediate
+            out.put16(0x2000 | (random.below(4) << 11) | (rd << 8) | random.skewed(256));
+            break;
+        case 3:
+        case 4:
+        case 5:
+            // ldr, str word with immediate offset
+            out.put16(0x6000 | (random.below(2) << 11) | (random.skewed(32) << 6) | (rn << 3) | rd);
+            break;
+        case 6:
+            // ldrh, strh
+            out.put16(0x8000 | (random.below(2) << 11) | (random.skewed(32) << 6) | (rn << 3) | rd);
+            break;
+        case 7:
+        case 8:
+            // ALU operations
+            out.put16(0x4000 | (random.below(16) << 6) | (rn << 3) | rd);
+            break;
+        case 9:
+            // lsl, lsr immediate
+            out.put16((random.below(2) << 11) | (random.skewed(32) << 6) | (rn << 3) | rd);
+            break;
+        case 10:
+            // add, sub register
+            out.put16(0x1800 | (random.below(2) << 9) | (random.skewed(8) << 6) | (rn << 3) | rd);
+            break;
+        case 11:
+            // ldr pc-relative, from the literal pool following the function
+            out.put16(0x4800 | (rd << 8) | (pool.size() & 0xff));
+            pool.push_back(0);
+            break;
+        case 12:
+            // Conditional branch, mostly short and backwards
+            out.put16(0xd000 | (random.below(14) << 8) | ((0x100 - random.skewed(32)) & 0xff));
+            break;
+        case 13:
+        {
+            // bl to an earlier function. The same functions are called over and over again.
+            const size_t target = functions.empty() ? 0 : functions[functions.size() - 1 - random.skewed(static_cast<uint32_t>(std::min<size_t>(functions.size(), 16)))];
+            const uint32_t offset = static_cast<uint32_t>((static_cast<int64_t>(target) - static_cast<int64_t>(out.size() + 4)) >> 1);
+            out.put16(0xf000 | ((offset >> 11) & 0x7ff));
+            out.put16(0xf800 | (offset & 0x7ff));
+            break;
+        }
+        case 14:
+            // mov high registers, bx
+            out.put16(random.below(4) ? 0x4600 | (random.below(16) << 3) | rd : 0x4700 | (random.skewed(16) << 3));
+            break;
+        default:
+            // ldr sp-relative
+            out.put16(0x9800 | (rd << 8) | random.skewed(16));
+            break;
+    }
+}
+
+// Thumb functions, each with its literal pool. Some functions are copies of earlier ones, like inlined or instantiated code.
+void write_thumb_code(image_writer& out, random_generator& random, size_t end, size_t image_size)
+{
+    vector<size_t> functions;
+    vector<std::array<size_t, 2>> bodies;
+    while (out.size() < end)
+    {
+        functions.push_back(out.size());
+        if (!bodies.empty() && (random.below(8) == 0))
+        {
+            const auto& body = bodies[bodies.size() - 1 - random.skewed(static_cast<uint32_t>(bodies.size()))];
+            out.repeat(body[0], body[1]);
+            continue;
+        }
+
+        const size_t begin = out.size();
+        const uint32_t registers = random.below(16) << 4;
+        vector<uint32_t> pool;
+        out.put16(0xb500 | registers);
+        for (auto n = 4 + random.skewed(48); n; --n)
+        {
+            write_thumb_instruction(out, random, pool, functions);
+        }
+        out.put16(0xbd00 | registers);
+        out.align(4);
+        for (auto& literal : pool)
+        {
+            literal = make_literal(random, image_size);
+            out.put32(literal);
+        }
+        bodies.push_back({ begin, out.size() });
+    }
+}
+
+void write_code(image_writer& out, size_t end, uint32_t seed)
+{
+    random_generator random(seed);
+    const size_t arm_end = std::min(end, out.size() + std::max<size_t>(64, (end - out.size()) / 8));
+    write_arm_code(out, random, arm_end);
+    write_thumb_code(out, random, end, end);
+}
+
+// Sine table with 16 bit entries, using a parabola instead of sin, so that the table is the same everywhere.
+void write_sine_table(image_writer& out, random_generator& random)
+{
+    const int n = 256 << random.below(2);
+    const int amplitude = 1 << (8 + random.below(7));
+    const int half = n / 2;
+    for (int i = 0; i < n; ++i)
+    {
+        const int x = i % half;
+        const int64_t value = static_cast<int64_t>(4) * x * (half - x) * amplitude / (static_cast<int64_t>(half) * half);
+        out.put16(static_cast<uint32_t>(i < half ? value : -value));
+    }
+}
+
+// 15 bit BGR palette with gradients between random colors.
+void write_palette(image_writer& out, random_generator& random)
+{
+    const int gradients = 1 << random.below(5);
+    for (int g = 0; g < gradients; ++g)
+    {
+        const uint32_t from = random.below(0x8000);
+        const uint32_t to = random.below(0x8000);
+        for (int i = 0; i < 16; ++i)
+        {
+            uint32_t color = 0;
+            for (int c = 0; c < 15; c += 5)
+            {
+                const int a = (from >> c) & 31;
+                const int b = (to >> c) & 31;
+                color |= static_cast<uint32_t>(a + (b - a) * i / 15) << c;
+            }
+            out.put16(color);
+        }
+    }
+}
+
+// 32x32 tile map. Mostly consecutive tiles, with some repeated and flipped ones.
+void write_tile_map(image_writer& out, random_generator& random)
+{
+    const uint32_t base = random.skewed(512);
+    const uint32_t palette = random.skewed(16) << 12;
+    for (uint32_t i = 0; i < 32 * 32; ++i)
+    {
+        uint32_t tile = base + i;
+        if (random.below(4) == 0)
+        {
+            tile = random.skewed(16) | (random.below(4) << 10);
+        }
+        out.put16(palette | (tile & 0xfff));
+    }
+}
+
+// Object records: { int16 x, y; uint8 type, flags; uint16 id; }, sorted by position.
+void write_records(image_writer& out, random_generator& random)
+{
+    uint32_t x = random.below(64);
+    uint32_t y = random.below(64);
+    for (auto n = 16 + random.below(112); n; --n)
+    {
+        x += random.skewed(32);
+        y = (y + random.skewed(16) - 4) & 0xff;
+        out.put16(x);
+        out.put16(y);
+        out.put8(random.skewed(8));
+        out.put8(random.below(4) ? 0 : random.below(256));
+        out.put16(n);
+    }
+}
+
+void write_strings(image_writer& out, random_generator& random)
+{
+    static constexpr const char* words[] =
+    {
+        "the", "level", "score", "press", "start", "game", "over", "player", "bonus", "time",
+        "lives", "high", "world", "enter", "name", "select", "options", "sound", "music", "continue"
+    };
+    for (auto n = 4 + random.below(28); n; --n)
+    {
+        for (auto w = 1 + random.skewed(6); w; --w)
+        {
+            for (const char* c = words[random.skewed(std::size(words))]; *c; ++c)
+            {
+                out.put8(static_cast<unsigned char>(*c));
+            }
+            out.put8(w > 1 ? ' ' : 0);
+        }
+    }
+    out.align(4);
+}
+
+void write_tables(image_writer& out, size_t end, uint32_t seed)
+{
+    random_generator random(seed);
+    while (out.size() < end)
+    {
+        switch (random.below(5))
+        {
+            case 0: write_sine_table(out, random); break;
+            case 1: write_palette(out, random); break;
+            case 2: write_tile_map(out, random); break;
+            case 3: write_records(out, random); break;
+            default: write_strings(out, random); break;
+        }
+        out.align(4);
+    }
+}
+
+// Code and tables at both ends of a padded image, each taking a quarter of it.
+size_t padded_section_size(size_t size)
+{
+    return std::max<size_t>(4, size / 4) & ~size_t(3);
+}
+
+uint32_t make_seed(corpus_kind kind, size_t size)
+{
+    return static_cast<uint32_t>(size * 2654435761u) ^ (static_cast<uint32_t>(kind) + 1) * 0x9e3779b9u;
+}
+
+void add_section(ELFIO::elfio& writer, const char* name, ELFIO::Elf_Xword flags, uint32_t address, const unsigned char* data, size_t size)
+{
+    ELFIO::section* section = writer.sections.add(name);
+    section->set_type(SHT_PROGBITS);
+    section->set_flags(SHF_ALLOC | flags);
+    section->set_addr_align(4);
+    section->set_address(address);
+    section->set_data(reinterpret_cast<const char*>(data), static_cast<ELFIO::Elf_Word>(size));
+}
+
+}
+
+std::string to_string(corpus_kind kind)
+{
+    switch (kind)
+    {
+        case corpus_kind::code: return "code";
+        case corpus_kind::table: return "table";
+        case corpus_kind::padded: return "padded";
+    }
+    throw std::invalid_argument("kind");
+}
+
+corpus_kind parse_corpus_kind(const std::string& name)
+{
+    for (auto kind : { corpus_kind::code, corpus_kind::table, corpus_kind::padded })
+    {
+        if (name == to_string(kind))
+        {
+            return kind;
+        }
+    }
+    throw std::runtime_error(std::format("unknown corpus kind '{}'", name));
+}
+
+vector<unsigned char> make_corpus_data(corpus_kind kind, size_t size)
+{
+    vector<unsigned char> data;
+    image_writer out(data);
+    const uint32_t seed = make_seed(kind, size);
+
+    switch (kind)
+    {
+        case corpus_kind::code:
+            write_code(out, size, seed);
+            break;
+        case corpus_kind::table:
+            write_tables(out, size, seed);
+            break;
+        case corpus_kind::padded:
+        {
+            const size_t section_size = padded_section_size(size);
+            write_code(out, section_size, seed);
+            data.resize(size - section_size, 0);
+            write_tables(out, size, seed + 1);
+            break;
+        }
+    }
+
+    data.resize(size);
+    return data;
+}
+
+void write_corpus_file(const std::filesystem::path& path, corpus_kind kind, size_t size)
+{
+    const auto data = make_corpus_data(kind, size);
+
+    ELFIO::elfio writer;
+    writer.create(ELFCLASS32, ELFDATA2LSB);
+    writer.set_os_abi(ELFOSABI_NONE);
+    writer.set_type(ET_EXEC);
+    writer.set_machine(EM_ARM);
+    writer.set_entry(corpus_load_address);
+
+    switch (kind)
+    {
+        case corpus_kind::code:
+            add_section(writer, ".text", SHF_EXECINSTR, corpus_load_address, data.data(), data.size());
+            break;
+        case corpus_kind::table:
+            add_section(writer, ".rodata", 0, corpus_load_address, data.data(), data.size());
+            break;
+        case corpus_kind::padded:
+        {
+            const size_t section_size = padded_section_size(size);
+            const size_t rodata = size - section_size;
+            add_section(writer, ".text", SHF_EXECINSTR, corpus_load_address, data.data(), section_size);
+            add_section(writer, ".rodata", 0, corpus_load_address + static_cast<uint32_t>(rodata), data.data() + rodata, size - rodata);
+            break;
+        }
+    }
+
+    if (!writer.save(path.string()))
+    {
+        throw std::runtime_error(std::format("Could not write {}", path.string()));
+    }
+}
+
+vector<corpus_entry> write_corpus(const std::filesystem::path& directory, const vector<corpus_kind>& kinds, const vector<size_t>& sizes)
+{
+    std::filesystem::create_directories(directory);
+
+    vector<corpus_entry> corpus;
+    for (auto kind : kinds)
+    {
+        for (auto size : sizes)
+        {
+            const auto name = std::format("{}-{}k", to_string(kind), size / 1024);
+            const auto path = directory / (name + ".elf");
+            write_corpus_file(path, kind, size);
+            corpus.push_back({ name, kind, size, path });
+        }
+    }
+    return corpus;
+}
+
+}
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_BENCHMARK_SYNTHETIC_CORPUS_HPP
+#define SHRINKLERGBACORE_BENCHMARK_SYNTHETIC_CORPUS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace shrinklergbacore_benchmark
+{
+
+// Kinds of synthetic GBA programs:
+// code: ARM startup code followed by Thumb functions with literal pools, as produced by a compiler.
+// table: sine tables, palettes, tile maps, records and strings.
+// padded: code and tables with a large zero filled hole in between, like an image with aligned sections.
+enum class corpus_kind
+{
+    code,
+    table,
+    padded
+};
+
+std::string to_string(corpus_kind kind);
+
+// Throws std::runtime_error if the name is not the name of a kind.
+corpus_kind parse_corpus_kind(const std::string& name);
+
+// Address at which corpus images are loaded.
+constexpr uint32_t corpus_load_address = 0x02000000;
+
+struct corpus_entry
+{
+    std::string name;
+    corpus_kind kind;
+    size_t size;
+    std::filesystem::path path;
+};
+
+// Returns the data of an image of the given kind and size.
+// The data depends only on kind and size, so that results of different machines and builds can be compared.
+std::vector<unsigned char> make_corpus_data(corpus_kind kind, size_t size);
+
+// Writes the image of the given kind and size as a 32-bit ARM executable ELF file, which loads it to corpus_load_address.
+// The entry point is the start of the image. Padded images consist of two sections, so that the hole is filled in when the ELF is loaded.
+void write_corpus_file(const std::filesystem::path& path, corpus_kind kind, size_t size);
+
+// Writes one file per kind and size into directory, which is created if needed.
+std::vector<corpus_entry> write_corpus(const std::filesystem::path& directory, const std::vector<corpus_kind>& kinds, const std::vector<size_t>& sizes);
+
+}
+
+#endif
@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_BATCH_PACKER_HPP
+#define SHRINKLERGBACORE_BATCH_PACKER_HPP
+
+#include <istream>
+#include <string>
+#include <vector>
+#include "shrinklergbacore/options.hpp"
+
+namespace shrinklergbacore
+{
+
+// Reads the entries of a batch manifest.
+// Each line holds the command line for one file, without the program name, e.g. "intro.elf -p9 -o intro.gba".
+// Empty lines and lines starting with # are ignored. Arguments containing spaces can be enclosed in double quotes.
+// Each entry starts out with the default options, but uses a single thread unless its line specifies -j.
+// Errors are reported using manifest_name and the line number. If silent is true, the command line parser prints nothing.
+std::vector<options> read_manifest(std::istream& manifest, const std::string& manifest_name, const options& defaults, bool silent);
+
+// Packs all files listed in a batch manifest on a pool of threads.
+// The largest input files are started first, so that they do not end up running alone at the end.
+// Messages of each file are printed together once the file is done, followed by its cart size and packing time.
+// Files which cannot be packed do not stop the others from being packed.
+class batch_packer final
+{
+public:
+    void pack(const options& options);
+};
+
+}
+
+#endif
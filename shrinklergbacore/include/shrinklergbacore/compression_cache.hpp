@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_COMPRESSION_CACHE_HPP
+#define SHRINKLERGBACORE_COMPRESSION_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+#include "shrinklerwrapper/shrinklerwrapper.hpp"
+
+namespace shrinklergbacore
+{
+
+// Cache of compressed data on disk, so that data which was compressed before need not be compressed again.
+// Each entry is a file in the cache directory, named after its key.
+// Entries are written to a temporary file which is then renamed, so any number of processes and threads
+// can use the same cache directory at the same time without ever seeing partially written entries.
+// When the entries take up more than the maximum size, the least recently used ones are removed.
+// Temporary files left behind by writers which crashed are removed at the same time.
+// The cache never causes packing to fail: entries which cannot be read count as misses, and store reports failure.
+class compression_cache final
+{
+public:
+    compression_cache(const std::filesystem::path& directory, uintmax_t max_size) : m_directory(directory), m_max_size(max_size) {}
+
+    // SHA-256 of the data, all compression parameters which affect the compressed data and the version of shrinkler-gba.
+    // The number of threads, the verbose flag and the stop token are not part of the key, since they do not change the compressed data.
+    static std::string key(std::span<const unsigned char> data, const shrinklerwrapper::shrinkler_parameters& parameters);
+
+    // Whether data compressed with the given parameters may be cached.
+    // Not when a time budget is set, since where compression stops depends on the speed and load of the machine,
+    // and not when compression was cancelled, which may have happened after the compressor returned.
+    static bool cacheable(const shrinklerwrapper::shrinkler_parameters& parameters);
+
+    // Returns the compressed data stored under key, if any, and marks the entry as recently used.
+    std::optional<std::vector<unsigned char>> load(const std::string& key) const;
+
+    // Stores compressed data under key, then removes least recently used entries if the cache is too big.
+    // The new entry itself is never removed, even if it alone exceeds the maximum size.
+    // Returns false if the entry could not be written.
+    bool store(const std::string& key, const std::vector<unsigned char>& compressed_data) const;
+
+private:
+    std::filesystem::path entry_path(const std::string& key) const;
+    void evict(const std::filesystem::path& keep) const;
+
+    const std::filesystem::path m_directory;
+    const uintmax_t m_max_size;
+};
+
+}
+
+#endif
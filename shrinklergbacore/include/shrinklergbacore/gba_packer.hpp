@@ -5,6 +5,7 @@
 #ifndef SHRINKLERGBACORE_GBA_PACKER_HPP
 #define SHRINKLERGBACORE_GBA_PACKER_HPP
 
+#include <cstddef>
 #include <filesystem>
 #include <vector>
 #include "shrinklergbacore/options.hpp"
@@ -12,13 +13,22 @@
 namespace shrinklergbacore
 {
 
+class console;
 class input_file;
+class pack_statistics;
 
 class gba_packer final
 {
 public:
     void pack(const options& options);
+
+    // Packs using the given console for all messages. Returns the size of the cart written.
+    size_t pack(const options& options, const console& console);
 private:
+    std::vector<unsigned char> compress(const options& options, const console& console, const input_file& input_file, pack_statistics& statistics);
+    std::vector<unsigned char> search(const options& options, const console& console, const input_file& input_file, pack_statistics& statistics);
+    void write_statistics(const pack_statistics& statistics, const options& options, const console& console);
+    void pad_cart(std::vector<unsigned char>& cart_data, const console& console);
     void write_to_disk(const std::vector<unsigned char>& data, const std::filesystem::path& filename);
     void remove_output_file(const std::filesystem::path& filename);
 };
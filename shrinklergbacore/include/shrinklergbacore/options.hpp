@@ -5,12 +5,19 @@
 #ifndef SHRINKLERGBACORE_OPTIONS_HPP
 #define SHRINKLERGBACORE_OPTIONS_HPP
 
+#include <cstdint>
 #include <filesystem>
 #include "shrinklerwrapper/shrinklerwrapper.hpp"
 
 namespace shrinklergbacore
 {
 
+enum class stats_format
+{
+    none,
+    json
+};
+
 class options final
 {
 public:
@@ -47,6 +54,47 @@ public:
 
     void debug_checks(bool debug_checks) { m_debug_checks = debug_checks; }
 
+    bool search() const { return m_search; }
+
+    void search(bool search) { m_search = search; }
+
+    // Manifest listing the files to pack in batch mode. Empty if not in batch mode.
+    const std::filesystem::path& batch_file() const { return m_batch_file; }
+
+    void batch_file(const std::filesystem::path& batch_file) { m_batch_file = batch_file; }
+
+    bool output_file_set() const { return m_output_file_set; }
+
+    // Directory of the compression cache. Empty if no cache is used.
+    const std::filesystem::path& cache_directory() const { return m_cache_directory; }
+
+    void cache_directory(const std::filesystem::path& cache_directory) { m_cache_directory = cache_directory; }
+
+    // Maximum size of the compression cache in bytes.
+    uintmax_t cache_size() const { return m_cache_size; }
+
+    void cache_size(uintmax_t cache_size) { m_cache_size = cache_size; }
+
+    // Format of the timing and counter statistics printed after packing.
+    stats_format stats() const { return m_stats; }
+
+    void stats(stats_format stats) { m_stats = stats; }
+
+    // File to write the statistics to. Empty if they are printed to standard output.
+    const std::filesystem::path& stats_file() const { return m_stats_file; }
+
+    void stats_file(const std::filesystem::path& stats_file) { m_stats_file = stats_file; }
+
+    // File to write a Chrome trace event timeline of the packing phases to. Empty if no trace is written.
+    const std::filesystem::path& trace_file() const { return m_trace_file; }
+
+    void trace_file(const std::filesystem::path& trace_file) { m_trace_file = trace_file; }
+
+    // Number of threads to use. Zero means one thread per hardware thread.
+    unsigned int jobs() const { return m_jobs; }
+
+    void jobs(unsigned int jobs) { m_jobs = jobs; }
+
     const shrinklerwrapper::shrinkler_parameters& shrinkler_parameters() const { return m_shrinkler_parameters; }
 
     shrinklerwrapper::shrinkler_parameters& shrinkler_parameters() { return m_shrinkler_parameters; }
@@ -60,6 +108,14 @@ private:
     std::filesystem::path m_output_file;
     bool m_code_in_header = true;
     bool m_debug_checks = false;
+    bool m_search = false;
+    std::filesystem::path m_batch_file;
+    std::filesystem::path m_cache_directory;
+    uintmax_t m_cache_size = uintmax_t(1024) * 1024 * 1024;
+    stats_format m_stats = stats_format::none;
+    std::filesystem::path m_stats_file;
+    std::filesystem::path m_trace_file;
+    unsigned int m_jobs = 0;
     shrinklerwrapper::shrinkler_parameters m_shrinkler_parameters;
 };
 
@@ -0,0 +1,58 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_PACK_STATISTICS_HPP
+#define SHRINKLERGBACORE_PACK_STATISTICS_HPP
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "shrinklerwrapper/shrinklerwrapper.hpp"
+
+namespace shrinklergbacore
+{
+
+// Wall time of the phases of packing a file, and counters of the work done.
+// Times are reported relative to the construction of the pack_statistics.
+class pack_statistics final
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    pack_statistics() : m_begin(clock::now()) {}
+
+    // Adds a phase which is not part of a compression, e.g. loading the input file.
+    void add_phase(const std::string& name, clock::time_point begin, clock::time_point end);
+
+    // Adds the phases and counters of a compression.
+    void add(const shrinklerwrapper::compression_result& result);
+
+    // Adds value to the counter of the given name. Counters are reported in the order they were first added.
+    void add_counter(const std::string& name, long long value);
+
+    const std::vector<shrinklerwrapper::compression_phase>& phases() const { return m_phases; }
+
+    const std::vector<std::pair<std::string, long long>>& counters() const { return m_counters; }
+
+    // Writes total time, all phases, the time per phase name and the counters as JSON.
+    // Chains and passes are numbered from 1, as in verbose messages.
+    void write_json(std::ostream& stream) const;
+
+    // Writes the phases in Chrome's trace event format, which can be viewed in chrome://tracing or Perfetto.
+    // Each iteration chain is shown as a thread of its own.
+    void write_chrome_trace(std::ostream& stream) const;
+
+private:
+    double seconds_since_begin(clock::time_point t) const;
+
+    const clock::time_point m_begin;
+    std::vector<shrinklerwrapper::compression_phase> m_phases;
+    std::vector<std::pair<std::string, long long>> m_counters;
+};
+
+}
+
+#endif
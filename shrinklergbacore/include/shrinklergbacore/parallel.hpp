@@ -0,0 +1,25 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_PARALLEL_HPP
+#define SHRINKLERGBACORE_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+
+namespace shrinklergbacore
+{
+
+// Returns the number of worker threads to use for the given number of jobs.
+// A requested thread count of zero means to use one thread per hardware thread.
+unsigned int get_thread_count(unsigned int requested_threads, size_t njobs);
+
+// Runs job(0) to job(njobs - 1) on a pool of nthreads worker threads.
+// Jobs are started in ascending order of their index.
+// If a job throws, no further jobs are started and the first exception is rethrown once all workers have finished.
+void run_parallel(size_t njobs, unsigned int nthreads, const std::function<void(size_t)>& job);
+
+}
+
+#endif
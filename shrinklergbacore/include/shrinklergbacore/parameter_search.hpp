@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_PARAMETER_SEARCH_HPP
+#define SHRINKLERGBACORE_PARAMETER_SEARCH_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include "shrinklerwrapper/shrinklerwrapper.hpp"
+#include "shrinklergbacore/compression_cache.hpp"
+#include "shrinklergbacore/console.hpp"
+
+namespace shrinklergbacore
+{
+
+class search_result final
+{
+public:
+    shrinklerwrapper::shrinkler_parameters parameters;
+    std::vector<unsigned char> compressed_data;
+    size_t cart_size = 0;
+};
+
+// Returns the parameter sets tried by parameter_search.
+// These are all presets, each combined with larger values for effort and same length count.
+// All other parameters, including the number of references and the parity context setting, are taken from base.
+// The parity context setting is not varied, since the depacker always uses parity contexts.
+std::vector<shrinklerwrapper::shrinkler_parameters> make_search_grid(const shrinklerwrapper::shrinkler_parameters& base);
+
+// Compresses the same data with a grid of parameter sets on a pool of threads.
+// All compressions share a single suffix array. Returns the result giving the smallest cart.
+// If more than one result gives the smallest cart, the one whose parameters come first in the grid is returned.
+// If a cache is given, parameter sets whose compressed data is in the cache are not compressed again.
+class parameter_search final
+{
+public:
+    using cart_size_function = std::function<size_t(const std::vector<unsigned char>& compressed_data)>;
+
+    parameter_search(const console& console, unsigned int threads, const compression_cache* cache = nullptr)
+        : m_console(console), m_threads(threads), m_cache(cache) {}
+
+    search_result run(
+        const std::vector<unsigned char>& data,
+        const std::vector<shrinklerwrapper::shrinkler_parameters>& grid,
+        const cart_size_function& cart_size) const;
+
+private:
+    const console m_console;
+    const unsigned int m_threads;
+    const compression_cache* const m_cache;
+};
+
+}
+
+#endif
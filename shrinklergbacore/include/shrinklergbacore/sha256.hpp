@@ -0,0 +1,47 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERGBACORE_SHA256_HPP
+#define SHRINKLERGBACORE_SHA256_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace shrinklergbacore
+{
+
+// SHA-256 as specified in FIPS 180-4.
+class sha256 final
+{
+public:
+    using digest = std::array<unsigned char, 32>;
+
+    void update(std::span<const unsigned char> data);
+    void update(std::string_view s);
+
+    // Returns the digest of all data passed to update. The object must not be used afterwards.
+    digest finish();
+
+    // Returns the digest as 64 lowercase hexadecimal digits.
+    static std::string to_string(const digest& d);
+
+private:
+    void process_block(const unsigned char* block);
+
+    std::array<uint32_t, 8> m_state
+    {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+    std::array<unsigned char, 64> m_block{};
+    size_t m_block_size = 0;
+    uint64_t m_length = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,229 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "shrinklergbacore/batch_packer.hpp"
+#include "shrinklergbacore/command_line.hpp"
+#include "shrinklergbacore/console.hpp"
+#include "shrinklergbacore/gba_packer.hpp"
+#include "shrinklergbacore/parallel.hpp"
+
+namespace shrinklergbacore
+{
+
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+// Splits a line into arguments separated by whitespace. Double quotes group characters including whitespace.
+static vector<string> split_arguments(const string& line)
+{
+    vector<string> arguments;
+    string argument;
+    bool in_argument = false;
+    bool in_quotes = false;
+
+    for (auto c : line)
+    {
+        if (c == '"')
+        {
+            in_quotes = !in_quotes;
+            in_argument = true;
+        }
+        else if (!in_quotes && ((c == ' ') || (c == '\t') || (c == '\r')))
+        {
+            if (in_argument)
+            {
+                arguments.push_back(argument);
+                argument.clear();
+                in_argument = false;
+            }
+        }
+        else
+        {
+            argument.push_back(c);
+            in_argument = true;
+        }
+    }
+
+    if (in_quotes)
+    {
+        throw runtime_error("unterminated quote");
+    }
+    if (in_argument)
+    {
+        arguments.push_back(argument);
+    }
+
+    return arguments;
+}
+
+static options parse_entry(const vector<string>& arguments, const string& location, const options& defaults, bool silent)
+{
+    // The location takes the place of the program name, so that the command line parser's messages point to the line.
+    vector<vector<char>> strings;
+    strings.emplace_back(location.c_str(), location.c_str() + location.size() + 1);
+    for (const auto& a : arguments)
+    {
+        strings.emplace_back(a.c_str(), a.c_str() + a.size() + 1);
+    }
+    vector<char*> argv;
+    for (auto& s : strings)
+    {
+        argv.push_back(s.data());
+    }
+
+    options entry = defaults;
+    entry.batch_file({});
+    entry.jobs(1);
+    if (parse_command_line(static_cast<int>(argv.size()), argv.data(), entry, silent) != command_action::process)
+    {
+        throw runtime_error(std::format("{}: invalid entry", location));
+    }
+    if (!entry.batch_file().empty())
+    {
+        throw runtime_error(std::format("{}: --batch cannot be used in a manifest", location));
+    }
+    if (!entry.trace_file().empty())
+    {
+        // Every file would write its timeline to the same trace file.
+        throw runtime_error(std::format("{}: --trace cannot be used with --batch", location));
+    }
+    if (!entry.stats_file().empty())
+    {
+        throw runtime_error(std::format("{}: --stats with a file cannot be used with --batch", location));
+    }
+
+    return entry;
+}
+
+vector<options> read_manifest(std::istream& manifest, const string& manifest_name, const options& defaults, bool silent)
+{
+    vector<options> entries;
+    string line;
+    int line_number = 0;
+
+    while (std::getline(manifest, line))
+    {
+        ++line_number;
+        const auto location = std::format("{}:{}", manifest_name, line_number);
+
+        vector<string> arguments;
+        try
+        {
+            arguments = split_arguments(line);
+        }
+        catch (const runtime_error& e)
+        {
+            throw runtime_error(std::format("{}: {}", location, e.what()));
+        }
+
+        if (arguments.empty() || arguments.front().starts_with('#'))
+        {
+            continue;
+        }
+
+        entries.push_back(parse_entry(arguments, location, defaults, silent));
+    }
+
+    return entries;
+}
+
+static uintmax_t input_size(const options& entry)
+{
+    // Missing files sort last. Their error is reported when they are packed.
+    std::error_code e;
+    auto size = std::filesystem::file_size(entry.input_file(), e);
+    return e ? 0 : size;
+}
+
+void batch_packer::pack(const options& options)
+{
+    console console;
+    console.verbose(options.verbose() ? &std::cout : nullptr);
+
+    if (!options.trace_file().empty())
+    {
+        throw runtime_error("--trace cannot be used with --batch");
+    }
+    if (!options.stats_file().empty())
+    {
+        throw runtime_error("--stats with a file cannot be used with --batch");
+    }
+
+    std::ifstream manifest(options.batch_file());
+    if (!manifest)
+    {
+        throw runtime_error(std::format("Could not open {}", options.batch_file().string()));
+    }
+    const auto entries = read_manifest(manifest, options.batch_file().string(), options, false);
+
+    // Largest inputs first. The sort is stable, so files of equal size are packed in manifest order.
+    vector<uintmax_t> sizes;
+    for (const auto& entry : entries)
+    {
+        sizes.push_back(input_size(entry));
+    }
+    vector<size_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sizes[a] > sizes[b]; });
+
+    const auto nthreads = get_thread_count(options.jobs(), entries.size());
+    CONSOLE_VERBOSE(console) << std::format("Packing {} files using {} threads", entries.size(), nthreads) << std::endl;
+
+    std::mutex output_mutex;
+    size_t failures = 0;
+    run_parallel(entries.size(), nthreads, [&](size_t i)
+    {
+        const auto& entry = entries[order[i]];
+
+        // Collect the messages of the file, so they can be printed in one piece.
+        std::ostringstream messages;
+        shrinklergbacore::console entry_console;
+        entry_console.out(&messages);
+        entry_console.warn(&messages);
+        entry_console.verbose(entry.verbose() ? &messages : nullptr);
+
+        const auto start = std::chrono::steady_clock::now();
+        string result;
+        bool failed = false;
+        try
+        {
+            gba_packer packer;
+            result = std::format("{} bytes", packer.pack(entry, entry_console));
+        }
+        catch (const std::exception& e)
+        {
+            result = std::format("error: {}", e.what());
+            failed = true;
+        }
+        const std::chrono::duration<double> seconds = std::chrono::steady_clock::now() - start;
+
+        std::scoped_lock lock(output_mutex);
+        failures += failed;
+        CONSOLE_OUT(console) << messages.str();
+        CONSOLE_OUT(console) << std::format("{} -> {}: {} ({:.2f} s)", entry.input_file().string(), entry.output_file().string(), result, seconds.count()) << std::endl;
+    });
+
+    if (failures)
+    {
+        throw runtime_error(std::format("{} of {} files could not be packed", failures, entries.size()));
+    }
+}
+
+}
@@ -3,8 +3,10 @@
 // shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
 
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <stdexcept>
+#include <string_view>
 #include <argp.h>
 #include "shrinklerwrapper/shrinklerwrapper.hpp"
 #include "shrinklergbacore/command_line.hpp"
@@ -18,6 +20,17 @@ enum option
     first = 256,
     no_code_in_header,
     debug_checks,
+    search,
+    range_index,
+    block_size,
+    chains,
+    batch,
+    cache,
+    cache_size,
+    time_budget,
+    convergence,
+    stats,
+    trace,
     usage
 };
 
@@ -43,6 +56,35 @@ public:
         case option::debug_checks:
             m_options.debug_checks(true);
             return 0;
+        case option::search:
+            m_options.search(true);
+            return 0;
+        case option::batch:
+            m_options.batch_file(arg);
+            return 0;
+        case option::cache:
+            m_options.cache_directory(arg);
+            return 0;
+        case option::cache_size:
+            return parse_cache_size(arg, state);
+        case option::stats:
+            return parse_stats(arg, state);
+        case option::trace:
+            m_options.trace_file(arg);
+            return 0;
+        case option::range_index:
+            m_options.shrinkler_parameters().range_index = true;
+            return 0;
+        case option::time_budget:
+            return parse_double("time budget", arg, 0.001, 1e6, state, m_options.shrinkler_parameters().time_budget);
+        case option::convergence:
+            return parse_double("convergence threshold", arg, 0.001, 1e6, state, m_options.shrinkler_parameters().convergence_threshold);
+        case option::block_size:
+            return parse_int("block size", arg, 1000, 100000000, state, m_options.shrinkler_parameters().parse_block_size);
+        case option::chains:
+            return parse_int("number of chains", arg, 1, 64, state, m_options.shrinkler_parameters().chains);
+        case 'j':
+            return parse_jobs(arg, state);
         case 'a':
             return parse_int("same length count", arg, 1, 100000, state, m_options.shrinkler_parameters().same_length);
         case 'e':
@@ -82,7 +124,7 @@ public:
                 return EINVAL;
             }
         case ARGP_KEY_NO_ARGS:
-            if (m_action != command_action::exit_success)
+            if ((m_action != command_action::exit_success) && m_options.batch_file().empty())
             {
                 argp_error(state, "no input file given");
                 return EINVAL;
@@ -91,6 +133,13 @@ public:
             {
                 return ARGP_ERR_UNKNOWN;
             }
+        case ARGP_KEY_END:
+            if (!m_options.batch_file().empty() && (m_inputfile_seen || m_options.output_file_set()))
+            {
+                argp_error(state, "input and output files cannot be given together with --batch");
+                return EINVAL;
+            }
+            return 0;
         default:
             return ARGP_ERR_UNKNOWN;
         }
@@ -126,6 +175,48 @@ private:
         return parse_result;
     }
 
+    int parse_jobs(const char* s, const argp_state* state)
+    {
+        int jobs = 0;
+        auto parse_result = parse_int("number of jobs", s, 1, 1024, state, jobs);
+
+        if (!parse_result)
+        {
+            m_options.jobs(jobs);
+        }
+
+        return parse_result;
+    }
+
+    int parse_cache_size(const char* s, const argp_state* state)
+    {
+        int megabytes = 0;
+        auto parse_result = parse_int("cache size", s, 1, 1024 * 1024, state, megabytes);
+
+        if (!parse_result)
+        {
+            m_options.cache_size(uintmax_t(megabytes) * 1024 * 1024);
+        }
+
+        return parse_result;
+    }
+
+    int parse_stats(const char* s, const argp_state* state)
+    {
+        // Either FORMAT or FORMAT:FILE
+        const std::string_view format(s);
+        const auto separator = format.find(':');
+        if ((format.substr(0, separator) != "json") || ((separator != format.npos) && (separator + 1 == format.size())))
+        {
+            argp_failure(state, EXIT_FAILURE, 0, "invalid statistics format: %s", s);
+            return EINVAL;
+        }
+
+        m_options.stats(stats_format::json);
+        m_options.stats_file(separator != format.npos ? std::filesystem::path(format.substr(separator + 1)) : std::filesystem::path());
+        return 0;
+    }
+
     static int parse_int(const char* value_description, const char* s, int min, int max, const argp_state* state, int& parsed_int)
     {
         char* end;
@@ -143,6 +234,21 @@ private:
         return 0;
     }
 
+    static int parse_double(const char* value_description, const char* s, double min, double max, const argp_state* state, double& parsed_double)
+    {
+        char* end;
+        auto value = strtod(s, &end);
+
+        if ((end == s) || (*end) || !(value >= min) || (value > max))
+        {
+            argp_failure(state, EXIT_FAILURE, 0, "invalid %s: %s", value_description, s);
+            return EINVAL;
+        }
+
+        parsed_double = value;
+        return 0;
+    }
+
     command_action m_action = command_action::process;
     bool m_inputfile_seen = false;
     options& m_options;
@@ -170,13 +276,19 @@ command_action parse_command_line(int argc, char* argv[], options& options, bool
         SHRINKLERGBA_PROJECT_NAME " - Shrinkler for the Gameboy Advance by Tom/Vantage\n"
         "Shrinkler compression by Blueberry/Loonies\n"
         "https://github.com/tom42/shrinkler-gba";
-    static const char args_doc[] = "FILE";
+    static const char args_doc[] = "FILE\n--batch=MANIFEST";
 
     static const argp_option argp_options[] =
     {
         { 0, 0, 0, 0, "General options:", 0 },
         { "output-file", 'o', "FILE", 0, "Specify output filename. The default output filename is the input filename with the extension replaced by .gba", 0 },
         { "verbose", 'v', 0, 0, "Print verbose messages", 0 },
+        { "jobs", 'j', "N", 0, "Number of threads to use (default: number of hardware threads)", 0 },
+        { "batch", option::batch, "MANIFEST", 0, "Pack all files listed in MANIFEST, one command line per line. Files are packed in parallel, largest first", 0 },
+        { "cache", option::cache, "DIR", 0, "Keep compressed data in DIR and reuse it when the same data is compressed again with the same options", 0 },
+        { "cache-size", option::cache_size, "MB", 0, "Maximum size of the cache in megabytes. Least recently used data is removed first (1024)", 0 },
+        { "stats", option::stats, "FORMAT[:FILE]", 0, "Write the time spent in each phase and counters of the work done to FILE. FORMAT must be json. Without FILE, the statistics are printed to standard output and all other messages to standard error", 0 },
+        { "trace", option::trace, "FILE", 0, "Write a timeline of the phases to FILE in Chrome's trace event format", 0 },
 
         // Code generation options
         { 0, 0, 0, 0, "Code generation options:", 0 },
@@ -185,13 +297,19 @@ command_action parse_command_line(int argc, char* argv[], options& options, bool
 
         // Shrinkler compression options
         { 0, 0, 0, 0, "Shrinkler compression options (default values in parentheses):", 0 },
+        { "block-size", option::block_size, "N", 0, "Parse blocks of N bytes in parallel. Faster for large inputs, but compresses slightly worse (off)", 0 },
+        { "chains", option::chains, "N", 0, "Run N iteration chains in parallel, each starting from a different initial model, and keep the best result (1)", 0 },
+        { "convergence", option::convergence, "BYTES", 0, "Stop once a pass gains fewer than BYTES bytes (off)", 0 },
         { "same-length", 'a', "N", 0, "Number of matches of the same length to consider (20)", 0 },
         { "effort", 'e', "N", 0, "Perseverance in finding multiple matches (200)", 0 },
         { "iterations", 'i', "N", 0, "Number of iterations for the compression (2)", 0 },
         { "length-margin", 'l', "N", 0, "Number of shorter matches considered for each match (2)", 0 },
         { "preset", 'p', "PRESET", 0, "Preset for all compression options except --references (1..9, default 2)", 0 },
+        { "range-index", option::range_index, 0, 0, "Find matches using a range index over the suffix array. Never gives up finding matches, --effort is ignored", 0 },
         { "references", 'r', "N", 0, "Number of reference edges to keep in memory (100000)", 0 },
         { "skip-length", 's', "N", 0, "Minimum match length to accept greedily (2000)", 0 },
+        { "time-budget", option::time_budget, "SECONDS", 0, "Stop compressing after SECONDS seconds and keep the best result so far. The first pass always completes (off)", 0 },
+        { "search", option::search, 0, 0, "Try all presets with increased effort and same length values in parallel, keep the smallest cart", 0 },
 
         // argp always forces "help" and "version" into group -1, but not "usage".
         // But we want "usage" to be there too, so we explicitly specify -1 for "help".
@@ -0,0 +1,208 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <system_error>
+#include <tuple>
+#include "shrinklergbacore/compression_cache.hpp"
+#include "shrinklergbacore/sha256.hpp"
+#include "shrinklergbacore_version.hpp"
+
+namespace shrinklergbacore
+{
+
+namespace fs = std::filesystem;
+
+// Entries consist of a header and the compressed data. The header holds a magic value,
+// the size of the compressed data and its SHA-256, so that damaged entries can be detected.
+static constexpr char entry_magic[4] = { 'S', 'G', 'C', '2' };
+static constexpr size_t entry_size_offset = sizeof(entry_magic);
+static constexpr size_t entry_digest_offset = entry_size_offset + 4;
+static constexpr size_t entry_header_size = entry_digest_offset + std::tuple_size_v<sha256::digest>;
+static constexpr const char* entry_extension = ".sgc";
+static constexpr const char* temporary_extension = ".tmp";
+
+// Temporary files older than this were left behind by a writer which crashed or was killed.
+static constexpr auto stale_temporary_file_age = std::chrono::hours(1);
+
+static sha256::digest payload_digest(std::span<const unsigned char> compressed_data)
+{
+    sha256 h;
+    h.update(compressed_data);
+    return h.finish();
+}
+
+std::string compression_cache::key(std::span<const unsigned char> data, const shrinklerwrapper::shrinkler_parameters& parameters)
+{
+    const auto& p = parameters;
+    sha256 h;
+    h.update(std::format(
+        "{} {}\n"
+        "iterations={} length_margin={} same_length={} effort={} skip_length={} references={} parity_context={} "
+        "precompute_matches={} range_index={} parse_block_size={} chains={} time_budget={} convergence_threshold={}\n",
+        SHRINKLERGBA_PROJECT_NAME, SHRINKLERGBA_PROJECT_VERSION,
+        p.iterations, p.length_margin, p.same_length, p.effort, p.skip_length, p.references, p.parity_context,
+        p.precompute_matches, p.range_index, p.parse_block_size, p.chains, p.time_budget, p.convergence_threshold));
+    h.update(data);
+    return sha256::to_string(h.finish());
+}
+
+bool compression_cache::cacheable(const shrinklerwrapper::shrinkler_parameters& parameters)
+{
+    return !(parameters.time_budget > 0) && !parameters.stop_token.stop_requested();
+}
+
+std::optional<std::vector<unsigned char>> compression_cache::load(const std::string& key) const
+{
+    const auto path = entry_path(key);
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return std::nullopt;
+    }
+
+    std::vector<unsigned char> entry{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if ((entry.size() < entry_header_size) || !std::equal(std::begin(entry_magic), std::end(entry_magic), entry.begin()))
+    {
+        return std::nullopt;
+    }
+    const auto* size_bytes = &entry[entry_size_offset];
+    const auto size = size_bytes[0] | (size_bytes[1] << 8) | (size_bytes[2] << 16) | (size_t(size_bytes[3]) << 24);
+    if (entry.size() - entry_header_size != size)
+    {
+        return std::nullopt;
+    }
+    std::vector<unsigned char> compressed_data(entry.begin() + entry_header_size, entry.end());
+    const auto digest = payload_digest(compressed_data);
+    if (!std::equal(digest.begin(), digest.end(), entry.begin() + entry_digest_offset))
+    {
+        return std::nullopt;
+    }
+
+    // Least recently used is tracked using the modification time. Another process may have removed the entry by now.
+    std::error_code e;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), e);
+
+    return compressed_data;
+}
+
+bool compression_cache::store(const std::string& key, const std::vector<unsigned char>& compressed_data) const
+{
+    std::error_code e;
+    fs::create_directories(m_directory, e);
+    if (e)
+    {
+        return false;
+    }
+
+    // The random part of the temporary file name keeps concurrent writers of the same entry apart.
+    std::random_device random;
+    const auto path = entry_path(key);
+    auto temporary_path = path;
+    temporary_path += std::format(".{:08x}{:08x}{}", random(), random(), temporary_extension);
+
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        const auto size = compressed_data.size();
+        const auto digest = payload_digest(compressed_data);
+        const char header[entry_digest_offset] =
+        {
+            entry_magic[0], entry_magic[1], entry_magic[2], entry_magic[3],
+            char(size & 0xff), char((size >> 8) & 0xff), char((size >> 16) & 0xff), char((size >> 24) & 0xff)
+        };
+        file.write(header, sizeof(header));
+        file.write(reinterpret_cast<const char*>(digest.data()), digest.size());
+        file.write(reinterpret_cast<const char*>(compressed_data.data()), compressed_data.size());
+        file.close();
+        if (!file)
+        {
+            fs::remove(temporary_path, e);
+            return false;
+        }
+    }
+
+    fs::rename(temporary_path, path, e);
+    if (e)
+    {
+        fs::remove(temporary_path, e);
+        return false;
+    }
+
+    evict(path);
+    return true;
+}
+
+fs::path compression_cache::entry_path(const std::string& key) const
+{
+    return m_directory / (key + entry_extension);
+}
+
+void compression_cache::evict(const fs::path& keep) const
+{
+    struct entry
+    {
+        fs::path path;
+        uintmax_t size;
+        fs::file_time_type last_used;
+    };
+
+    // Errors are ignored, since other processes may be adding and removing entries at the same time.
+    std::vector<entry> entries;
+    uintmax_t total_size = 0;
+    std::error_code e;
+    const auto now = fs::file_time_type::clock::now();
+    for (const auto& directory_entry : fs::directory_iterator(m_directory, e))
+    {
+        const auto extension = directory_entry.path().extension();
+        if ((extension != entry_extension) && (extension != temporary_extension))
+        {
+            continue;
+        }
+        const auto size = directory_entry.file_size(e);
+        if (e)
+        {
+            continue;
+        }
+        const auto last_used = directory_entry.last_write_time(e);
+        if (e)
+        {
+            continue;
+        }
+        if (extension == temporary_extension)
+        {
+            // Temporary files of writers which are still running are recent, so leave those alone.
+            if (now - last_used > stale_temporary_file_age)
+            {
+                fs::remove(directory_entry.path(), e);
+            }
+            continue;
+        }
+
+        // The entry just written counts towards the total size, but is never removed,
+        // even if it alone is bigger than the maximum size.
+        total_size += size;
+        if (directory_entry.path() != keep)
+        {
+            entries.push_back({ directory_entry.path(), size, last_used });
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const entry& a, const entry& b) { return a.last_used < b.last_used; });
+    for (const auto& entry : entries)
+    {
+        if (total_size <= m_max_size)
+        {
+            break;
+        }
+        fs::remove(entry.path, e);
+        total_size -= entry.size;
+    }
+}
+
+}
@@ -7,24 +7,59 @@
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <optional>
+#include <span>
 #include <string>
 #include <system_error>
 #include <vector>
 #include "shrinklerwrapper/shrinklerwrapper.hpp"
 #include "shrinklergbacore/cart_assembler.hpp"
+#include "shrinklergbacore/compression_cache.hpp"
 #include "shrinklergbacore/console.hpp"
 #include "shrinklergbacore/gba_packer.hpp"
 #include "shrinklergbacore/input_file.hpp"
+#include "shrinklergbacore/pack_statistics.hpp"
+#include "shrinklergbacore/parallel.hpp"
+#include "shrinklergbacore/parameter_search.hpp"
 
 namespace shrinklergbacore
 {
 
+static depacker_settings make_depacker_settings(const options& options)
+{
+    return
+    {
+        .code_in_header = options.code_in_header(),
+        .debug_checks = options.debug_checks()
+    };
+}
+
+static std::optional<compression_cache> make_cache(const options& options)
+{
+    if (options.cache_directory().empty() || !compression_cache::cacheable(options.shrinkler_parameters()))
+    {
+        return std::nullopt;
+    }
+    return compression_cache(options.cache_directory(), options.cache_size());
+}
+
 void gba_packer::pack(const options& options)
 {
+    // Statistics printed to standard output must not be mixed with other messages.
+    auto messages = ((options.stats() != stats_format::none) && options.stats_file().empty()) ? &std::cerr : &std::cout;
     console console;
-    console.verbose(options.verbose() ? &std::cout : nullptr);
+    console.warn(messages);
+    console.verbose(options.verbose() ? messages : nullptr);
+    pack(options, console);
+}
+
+size_t gba_packer::pack(const options& options, const console& console)
+{
+    pack_statistics statistics;
 
     // Load program
+    auto begin = pack_statistics::clock::now();
     input_file input_file(console);
     input_file.load(options.input_file());
     if (!input_file.loaded_data_size())
@@ -32,21 +67,141 @@ void gba_packer::pack(const options& options)
         // Shrinkler does really not like files with size zero.
         throw std::runtime_error("File is too small to be compressed");
     }
+    statistics.add_phase("load", begin, pack_statistics::clock::now());
 
     // Compress program
-    shrinklerwrapper::shrinkler_compressor compressor;
-    compressor.set_parameters(options.shrinkler_parameters());
-    auto compressed_program = compressor.compress(input_file.data());
+    auto compressed_program = options.search() ? search(options, console, input_file, statistics) : compress(options, console, input_file, statistics);
 
     // Assemble cart
-    const depacker_settings depacker_settings
+    begin = pack_statistics::clock::now();
+    cart_assembler cart_assembler(input_file, compressed_program, make_depacker_settings(options));
+    std::vector<unsigned char> cart_data = cart_assembler.data();
+    pad_cart(cart_data, console);
+    statistics.add_phase("assemble", begin, pack_statistics::clock::now());
+
+    CONSOLE_VERBOSE(console) << std::format("Uncompressed data size: {:4} bytes", input_file.data().size()) << std::endl;
+    CONSOLE_VERBOSE(console) << std::format("Compressed data size  : {:4} bytes", compressed_program.size()) << std::endl;
+    CONSOLE_VERBOSE(console) << std::format("Depacker size         : {:4} bytes (excluding code in cartridge header)", cart_assembler.depacker_size()) << std::endl;
+    CONSOLE_VERBOSE(console) << std::format("Cartridge size        : {:4} bytes", cart_data.size()) << std::endl;
+    CONSOLE_VERBOSE(console) << "Writing: " << options.output_file().string() << std::endl;
+    begin = pack_statistics::clock::now();
+    write_to_disk(cart_data, options.output_file());
+    statistics.add_phase("write", begin, pack_statistics::clock::now());
+
+    statistics.add_counter("uncompressed_size", input_file.data().size());
+    statistics.add_counter("compressed_size", compressed_program.size());
+    statistics.add_counter("cart_size", cart_data.size());
+    write_statistics(statistics, options, console);
+
+    return cart_data.size();
+}
+
+std::vector<unsigned char> gba_packer::compress(const options& options, const console& console, const input_file& input_file, pack_statistics& statistics)
+{
+    auto parameters = options.shrinkler_parameters();
+    parameters.threads = get_thread_count(options.jobs(), std::numeric_limits<size_t>::max());
+
+    const auto cache = make_cache(options);
+    const auto key = cache ? compression_cache::key(input_file.data(), parameters) : std::string();
+    if (cache)
     {
-        .code_in_header = options.code_in_header(),
-        .debug_checks = options.debug_checks()
+        const auto begin = pack_statistics::clock::now();
+        if (auto compressed_program = cache->load(key))
+        {
+            statistics.add_phase("cache_load", begin, pack_statistics::clock::now());
+            CONSOLE_VERBOSE(console) << "Using compressed data from cache" << std::endl;
+            return std::move(*compressed_program);
+        }
+    }
+
+    shrinklerwrapper::shrinkler_compressor compressor;
+    compressor.set_parameters(parameters);
+    const shrinklerwrapper::shrinkler_input input(std::span<const unsigned char>(input_file.data()), parameters.threads);
+    auto log = [&console](shrinklerwrapper::log_level level, const std::string& message)
+    {
+        if (level == shrinklerwrapper::log_level::warning)
+        {
+            CONSOLE_WARN(console) << message << std::endl;
+        }
+        else
+        {
+            CONSOLE_VERBOSE(console) << message << std::endl;
+        }
     };
-    cart_assembler cart_assembler(input_file, compressed_program, depacker_settings);
-    std::vector<unsigned char> cart_data = cart_assembler.data();
+    auto result = compressor.compress(input, log, nullptr);
+    statistics.add(result);
+    auto compressed_program = std::move(result.data);
+
+    if (cache && compression_cache::cacheable(parameters) && !cache->store(key, compressed_program))
+    {
+        CONSOLE_WARN(console) << "Could not write to cache directory " << options.cache_directory().string() << std::endl;
+    }
+
+    return compressed_program;
+}
+
+std::vector<unsigned char> gba_packer::search(const options& options, const console& console, const input_file& input_file, pack_statistics& statistics)
+{
+    // The compressions of the search run concurrently and are not broken down into phases.
+    const auto begin = pack_statistics::clock::now();
 
+    // Carts are assembled silently, otherwise warnings would be printed once per parameter set.
+    shrinklergbacore::console silent_console;
+    silent_console.warn(nullptr);
+
+    const auto cache = make_cache(options);
+    parameter_search search(console, options.jobs(), cache ? &*cache : nullptr);
+    auto result = search.run(
+        input_file.data(),
+        make_search_grid(options.shrinkler_parameters()),
+        [&](const std::vector<unsigned char>& compressed_program)
+        {
+            cart_assembler cart_assembler(input_file, compressed_program, make_depacker_settings(options));
+            std::vector<unsigned char> cart_data = cart_assembler.data();
+            pad_cart(cart_data, silent_console);
+            return cart_data.size();
+        });
+    statistics.add_phase("search", begin, pack_statistics::clock::now());
+
+    const auto& p = result.parameters;
+    CONSOLE_VERBOSE(console) << std::format("Best parameters: -i{} -l{} -a{} -e{} -s{}", p.iterations, p.length_margin, p.same_length, p.effort, p.skip_length) << std::endl;
+    return std::move(result.compressed_data);
+}
+
+void gba_packer::write_statistics(const pack_statistics& statistics, const options& options, const console& console)
+{
+    if (options.stats() == stats_format::json)
+    {
+        if (!options.stats_file().empty())
+        {
+            std::ofstream file(options.stats_file().string(), std::ios::trunc);
+            statistics.write_json(file);
+            file.close();
+            if (!file)
+            {
+                throw std::runtime_error(std::format("Could not write {}", options.stats_file().string()));
+            }
+        }
+        else if (console.is_out_enabled())
+        {
+            statistics.write_json(*console.out());
+        }
+    }
+
+    if (!options.trace_file().empty())
+    {
+        std::ofstream file(options.trace_file().string(), std::ios::trunc);
+        statistics.write_chrome_trace(file);
+        file.close();
+        if (!file)
+        {
+            throw std::runtime_error(std::format("Could not write {}", options.trace_file().string()));
+        }
+    }
+}
+
+void gba_packer::pad_cart(std::vector<unsigned char>& cart_data, const console& console)
+{
     // EZF Advance removes trailing 0xff bytes.
     // If the last byte is 0xff, pad the image so that nothing important is removed.
     if (cart_data.size() && (cart_data.back() == 0xff))
@@ -57,13 +212,6 @@ void gba_packer::pack(const options& options)
         cart_data.push_back('!');
         CONSOLE_WARN(console) << "Last byte of cart was 0xff. Appended padding word to protect against EZF Advance" << std::endl;
     }
-
-    CONSOLE_VERBOSE(console) << std::format("Uncompressed data size: {:4} bytes", input_file.data().size()) << std::endl;
-    CONSOLE_VERBOSE(console) << std::format("Compressed data size  : {:4} bytes", compressed_program.size()) << std::endl;
-    CONSOLE_VERBOSE(console) << std::format("Depacker size         : {:4} bytes (excluding code in cartridge header)", cart_assembler.depacker_size()) << std::endl;
-    CONSOLE_VERBOSE(console) << std::format("Cartridge size        : {:4} bytes", cart_data.size()) << std::endl;
-    CONSOLE_VERBOSE(console) << "Writing: " << options.output_file().string() << std::endl;
-    write_to_disk(cart_data, options.output_file());
 }
 
 void gba_packer::write_to_disk(const std::vector<unsigned char>& data, const std::filesystem::path& filename)
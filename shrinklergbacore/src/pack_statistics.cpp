@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <algorithm>
+#include <format>
+#include <string_view>
+#include "shrinklerwrapper/json.hpp"
+#include "shrinklergbacore/pack_statistics.hpp"
+
+namespace shrinklergbacore
+{
+
+using shrinklerwrapper::compression_phase;
+
+static std::string json_string(std::string_view s)
+{
+    return "\"" + shrinklerwrapper::escape_json(s) + "\"";
+}
+
+// Chains are shown as threads 1 and up. Everything else happens on thread 0.
+static int trace_thread(const compression_phase& phase)
+{
+    return phase.chain + 1;
+}
+
+void pack_statistics::add_phase(const std::string& name, clock::time_point begin, clock::time_point end)
+{
+    m_phases.push_back({ .name = name, .begin = begin, .end = end });
+}
+
+void pack_statistics::add(const shrinklerwrapper::compression_result& result)
+{
+    m_phases.insert(m_phases.end(), result.phases.begin(), result.phases.end());
+    add_counter("matches", result.counters.matches);
+    add_counter("skipped_positions", result.counters.skipped_positions);
+    add_counter("edges_created", result.counters.edges_created);
+    add_counter("edges_cleaned", result.counters.edges_cleaned);
+    add_counter("references_considered", result.references_considered);
+    add_counter("references_discarded", result.references_discarded);
+    add_counter("passes", static_cast<long long>(result.pass_sizes.size()));
+}
+
+void pack_statistics::add_counter(const std::string& name, long long value)
+{
+    auto counter = std::find_if(m_counters.begin(), m_counters.end(), [&](const auto& c) { return c.first == name; });
+    if (counter == m_counters.end())
+    {
+        m_counters.emplace_back(name, value);
+    }
+    else
+    {
+        counter->second += value;
+    }
+}
+
+void pack_statistics::write_json(std::ostream& stream) const
+{
+    auto end = m_begin;
+    std::vector<std::pair<std::string, double>> totals;
+    for (const auto& phase : m_phases)
+    {
+        end = std::max(end, phase.end);
+        const std::chrono::duration<double> seconds = phase.end - phase.begin;
+        auto total = std::find_if(totals.begin(), totals.end(), [&](const auto& t) { return t.first == phase.name; });
+        if (total == totals.end())
+        {
+            totals.emplace_back(phase.name, seconds.count());
+        }
+        else
+        {
+            total->second += seconds.count();
+        }
+    }
+
+    stream << "{\n";
+    stream << std::format("  \"total_seconds\": {:.6f},\n", seconds_since_begin(end));
+
+    stream << "  \"phases\": [";
+    for (size_t i = 0; i < m_phases.size(); ++i)
+    {
+        const auto& phase = m_phases[i];
+        const std::chrono::duration<double> seconds = phase.end - phase.begin;
+        stream << (i ? ",\n" : "\n") << "    {\"name\": " << json_string(phase.name);
+        if (phase.chain >= 0)
+        {
+            stream << ", \"chain\": " << phase.chain + 1;
+        }
+        if (phase.pass >= 0)
+        {
+            stream << ", \"pass\": " << phase.pass + 1;
+        }
+        stream << std::format(", \"start_seconds\": {:.6f}, \"seconds\": {:.6f}}}", seconds_since_begin(phase.begin), seconds.count());
+    }
+    stream << (m_phases.empty() ? "],\n" : "\n  ],\n");
+
+    stream << "  \"phase_totals\": {";
+    for (size_t i = 0; i < totals.size(); ++i)
+    {
+        stream << (i ? ",\n" : "\n") << std::format("    {}: {:.6f}", json_string(totals[i].first), totals[i].second);
+    }
+    stream << (totals.empty() ? "},\n" : "\n  },\n");
+
+    stream << "  \"counters\": {";
+    for (size_t i = 0; i < m_counters.size(); ++i)
+    {
+        stream << (i ? ",\n" : "\n") << std::format("    {}: {}", json_string(m_counters[i].first), m_counters[i].second);
+    }
+    stream << (m_counters.empty() ? "}\n" : "\n  }\n");
+    stream << "}" << std::endl;
+}
+
+void pack_statistics::write_chrome_trace(std::ostream& stream) const
+{
+    int threads = 1;
+    for (const auto& phase : m_phases)
+    {
+        threads = std::max(threads, trace_thread(phase) + 1);
+    }
+
+    stream << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    for (int thread = 0; thread < threads; ++thread)
+    {
+        const auto name = thread ? std::format("Chain {}", thread) : std::string("shrinkler-gba");
+        stream << std::format("  {{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": {}, \"args\": {{\"name\": {}}}}},\n", thread, json_string(name));
+    }
+    for (size_t i = 0; i < m_phases.size(); ++i)
+    {
+        const auto& phase = m_phases[i];
+        const std::chrono::duration<double, std::micro> duration = phase.end - phase.begin;
+        stream << std::format("  {{\"name\": {}, \"ph\": \"X\", \"pid\": 1, \"tid\": {}, \"ts\": {:.3f}, \"dur\": {:.3f}",
+            json_string(phase.name), trace_thread(phase), seconds_since_begin(phase.begin) * 1e6, duration.count());
+        if (phase.pass >= 0)
+        {
+            stream << std::format(", \"args\": {{\"pass\": {}}}", phase.pass + 1);
+        }
+        stream << "}" << (i + 1 < m_phases.size() ? ",\n" : "\n");
+    }
+    stream << "]}" << std::endl;
+}
+
+double pack_statistics::seconds_since_begin(clock::time_point t) const
+{
+    return std::chrono::duration<double>(t - m_begin).count();
+}
+
+}
@@ -0,0 +1,64 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "shrinklergbacore/parallel.hpp"
+
+namespace shrinklergbacore
+{
+
+unsigned int get_thread_count(unsigned int requested_threads, size_t njobs)
+{
+    auto nthreads = requested_threads ? requested_threads : std::max(std::thread::hardware_concurrency(), 1u);
+    return static_cast<unsigned int>(std::max<size_t>(std::min<size_t>(nthreads, njobs), 1));
+}
+
+void run_parallel(size_t njobs, unsigned int nthreads, const std::function<void(size_t)>& job)
+{
+    std::atomic<size_t> next_job = 0;
+    std::atomic<bool> failed = false;
+    std::exception_ptr first_exception;
+    std::mutex exception_mutex;
+
+    auto worker = [&]()
+    {
+        for (auto i = next_job++; (i < njobs) && !failed; i = next_job++)
+        {
+            try
+            {
+                job(i);
+            }
+            catch (...)
+            {
+                std::scoped_lock lock(exception_mutex);
+                if (!first_exception)
+                {
+                    first_exception = std::current_exception();
+                }
+                failed = true;
+            }
+        }
+    };
+
+    // The calling thread is the last worker, so a single thread does not spawn any threads at all.
+    std::vector<std::jthread> threads;
+    for (unsigned int i = 1; i < get_thread_count(nthreads, njobs); ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    threads.clear();
+
+    if (first_exception)
+    {
+        std::rethrow_exception(first_exception);
+    }
+}
+
+}
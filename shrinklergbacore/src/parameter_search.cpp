@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <format>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include "shrinklergbacore/parallel.hpp"
+#include "shrinklergbacore/parameter_search.hpp"
+#include "shrinklergbacore/table_printer.hpp"
+
+namespace shrinklergbacore
+{
+
+using shrinklerwrapper::shrinkler_compressor;
+using shrinklerwrapper::shrinkler_input;
+using shrinklerwrapper::shrinkler_parameters;
+
+std::vector<shrinkler_parameters> make_search_grid(const shrinkler_parameters& base)
+{
+    constexpr int min_preset = 1;
+    constexpr int max_preset = 9;
+    constexpr int scales[] = { 1, 4 };
+
+    // The effort does not matter when the range index is used, so do not vary it.
+    const auto effort_scales = base.range_index ? std::span(scales, 1) : std::span(scales);
+
+    std::vector<shrinkler_parameters> grid;
+    for (int preset = min_preset; preset <= max_preset; ++preset)
+    {
+        for (auto effort_scale : effort_scales)
+        {
+            for (auto same_length_scale : scales)
+            {
+                auto p = base;
+                p.preset(preset);
+                p.effort *= effort_scale;
+                p.same_length *= same_length_scale;
+                grid.push_back(p);
+            }
+        }
+    }
+
+    return grid;
+}
+
+search_result parameter_search::run(const std::vector<unsigned char>& data, const std::vector<shrinkler_parameters>& grid, const cart_size_function& cart_size) const
+{
+    const auto nthreads = get_thread_count(m_threads, grid.size());
+    CONSOLE_VERBOSE(m_console) << std::format("Searching {} parameter sets using {} threads", grid.size(), nthreads) << std::endl;
+
+    const shrinkler_input input(std::span<const unsigned char>(data), nthreads);
+    std::vector<size_t> cart_sizes(grid.size());
+    search_result best;
+    size_t best_index = grid.size();
+    std::mutex best_mutex;
+
+    run_parallel(grid.size(), nthreads, [&](size_t i)
+    {
+        // Verbose output from concurrently running compressors would be interleaved, so turn it off.
+        auto parameters = grid[i];
+        parameters.verbose = false;
+
+        // Failing to store an entry is not reported, since it would be reported once per parameter set.
+        const auto key = m_cache ? compression_cache::key(data, parameters) : std::string();
+        auto cached_data = m_cache ? m_cache->load(key) : std::nullopt;
+        std::vector<unsigned char> compressed_data;
+        if (cached_data)
+        {
+            compressed_data = std::move(*cached_data);
+        }
+        else
+        {
+            shrinkler_compressor compressor;
+            compressor.set_parameters(parameters);
+            compressed_data = compressor.compress(input);
+            if (m_cache && compression_cache::cacheable(parameters))
+            {
+                m_cache->store(key, compressed_data);
+            }
+        }
+        auto size = cart_size(compressed_data);
+
+        std::scoped_lock lock(best_mutex);
+        cart_sizes[i] = size;
+        if ((best_index == grid.size()) || (size < best.cart_size) || ((size == best.cart_size) && (i < best_index)))
+        {
+            best_index = i;
+            best.parameters = grid[i];
+            best.compressed_data = std::move(compressed_data);
+            best.cart_size = size;
+        }
+    });
+
+    if (m_console.is_verbose_enabled())
+    {
+        table_printer printer;
+        printer.table_indent(2);
+        printer.add_row({ "Iterations", "Length margin", "Same length", "Effort", "Skip length", "Cart size" });
+        for (size_t i = 0; i < grid.size(); ++i)
+        {
+            const auto& p = grid[i];
+            printer.add_row(
+            {
+                std::to_string(p.iterations),
+                std::to_string(p.length_margin),
+                std::to_string(p.same_length),
+                std::to_string(p.effort),
+                std::to_string(p.skip_length),
+                std::to_string(cart_sizes[i]) + (i == best_index ? " *" : "")
+            });
+        }
+        printer.print(*m_console.verbose());
+    }
+
+    return best;
+}
+
+}
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <algorithm>
+#include <bit>
+#include <format>
+#include "shrinklergbacore/sha256.hpp"
+
+namespace shrinklergbacore
+{
+
+static constexpr uint32_t round_constants[64] =
+{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+void sha256::update(std::span<const unsigned char> data)
+{
+    m_length += data.size();
+
+    while (!data.empty())
+    {
+        const auto n = std::min(data.size(), m_block.size() - m_block_size);
+        std::copy_n(data.begin(), n, m_block.begin() + m_block_size);
+        m_block_size += n;
+        data = data.subspan(n);
+
+        if (m_block_size == m_block.size())
+        {
+            process_block(m_block.data());
+            m_block_size = 0;
+        }
+    }
+}
+
+void sha256::update(std::string_view s)
+{
+    update(std::span(reinterpret_cast<const unsigned char*>(s.data()), s.size()));
+}
+
+sha256::digest sha256::finish()
+{
+    // Pad with a one bit, zeros and the length in bits, so that the total length is a multiple of 64 bytes.
+    const uint64_t length_in_bits = m_length * 8;
+    const unsigned char one_bit = 0x80;
+    update(std::span(&one_bit, 1));
+    const unsigned char zero = 0;
+    while (m_block_size != 56)
+    {
+        update(std::span(&zero, 1));
+    }
+    unsigned char length[8];
+    for (int i = 0; i < 8; ++i)
+    {
+        length[i] = static_cast<unsigned char>(length_in_bits >> (56 - 8 * i));
+    }
+    update(length);
+
+    digest d;
+    for (size_t i = 0; i < m_state.size(); ++i)
+    {
+        d[4 * i] = static_cast<unsigned char>(m_state[i] >> 24);
+        d[4 * i + 1] = static_cast<unsigned char>(m_state[i] >> 16);
+        d[4 * i + 2] = static_cast<unsigned char>(m_state[i] >> 8);
+        d[4 * i + 3] = static_cast<unsigned char>(m_state[i]);
+    }
+    return d;
+}
+
+std::string sha256::to_string(const digest& d)
+{
+    std::string s;
+    for (auto byte : d)
+    {
+        s += std::format("{:02x}", byte);
+    }
+    return s;
+}
+
+void sha256::process_block(const unsigned char* block)
+{
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) | (uint32_t(block[4 * i + 2]) << 8) | block[4 * i + 3];
+    }
+    for (int i = 16; i < 64; ++i)
+    {
+        const auto s0 = std::rotr(w[i - 15], 7) ^ std::rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const auto s1 = std::rotr(w[i - 2], 17) ^ std::rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    auto [a, b, c, d, e, f, g, h] = m_state;
+    for (int i = 0; i < 64; ++i)
+    {
+        const auto s1 = std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25);
+        const auto ch = (e & f) ^ (~e & g);
+        const auto t1 = h + s1 + ch + round_constants[i] + w[i];
+        const auto s0 = std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22);
+        const auto maj = (a & b) ^ (a & c) ^ (b & c);
+        const auto t2 = s0 + maj;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+}
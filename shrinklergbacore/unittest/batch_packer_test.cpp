@@ -0,0 +1,123 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <boost/test/unit_test.hpp>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "shrinklergbacore/batch_packer.hpp"
+#include "shrinklergbacore_unittest_config.hpp"
+#include "test_utilities.hpp"
+
+namespace shrinklergbacore_unittest
+{
+
+using shrinklergbacore::batch_packer;
+using shrinklergbacore::options;
+using std::runtime_error;
+
+static std::vector<options> read_manifest(const char* manifest, const options& defaults = options())
+{
+    std::istringstream s(manifest);
+    return shrinklergbacore::read_manifest(s, "manifest", defaults, true);
+}
+
+BOOST_AUTO_TEST_SUITE(batch_packer_test)
+
+    BOOST_AUTO_TEST_CASE(read_manifest_skips_empty_lines_and_comments)
+    {
+        auto entries = read_manifest("\n# comment\n  \na.elf\n  # indented comment\nb.elf\n");
+
+        BOOST_TEST(entries.size() == 2u);
+        BOOST_TEST(entries[0].input_file() == "a.elf");
+        BOOST_TEST(entries[0].output_file() == "a.gba");
+        BOOST_TEST(entries[1].input_file() == "b.elf");
+        BOOST_TEST(entries[1].output_file() == "b.gba");
+    }
+
+    BOOST_AUTO_TEST_CASE(read_manifest_parses_options_of_each_entry)
+    {
+        options defaults;
+        defaults.shrinkler_parameters().preset(3);
+        defaults.jobs(8);
+        defaults.batch_file("manifest");
+
+        auto entries = read_manifest("a.elf -o out/a.gba -p9\nb.elf -j 4\n", defaults);
+
+        BOOST_TEST(entries.size() == 2u);
+        BOOST_TEST(entries[0].output_file() == "out/a.gba");
+        BOOST_TEST(entries[0].shrinkler_parameters().iterations == 9);
+        BOOST_TEST(entries[0].jobs() == 1u);
+        BOOST_TEST(entries[0].batch_file() == "");
+        BOOST_TEST(entries[1].shrinkler_parameters().iterations == 3);
+        BOOST_TEST(entries[1].jobs() == 4u);
+    }
+
+    BOOST_AUTO_TEST_CASE(read_manifest_handles_quotes)
+    {
+        auto entries = read_manifest("\"my intro.elf\" -o \"my intro\".gba\n");
+
+        BOOST_TEST(entries.size() == 1u);
+        BOOST_TEST(entries[0].input_file() == "my intro.elf");
+        BOOST_TEST(entries[0].output_file() == "my intro.gba");
+    }
+
+    BOOST_AUTO_TEST_CASE(read_manifest_reports_errors_with_line_number)
+    {
+        CHECK_EXCEPTION(read_manifest("a.elf\nb.elf -p 0\n"), runtime_error, "manifest:2: invalid entry");
+        CHECK_EXCEPTION(read_manifest("a.elf -o\n"), runtime_error, "manifest:1: invalid entry");
+        CHECK_EXCEPTION(read_manifest("\"a.elf\n"), runtime_error, "manifest:1: unterminated quote");
+        CHECK_EXCEPTION(read_manifest("--help\n"), runtime_error, "manifest:1: invalid entry");
+        CHECK_EXCEPTION(read_manifest("--batch=other\n"), runtime_error, "manifest:1: --batch cannot be used in a manifest");
+        CHECK_EXCEPTION(read_manifest("a.elf --trace=trace.json\n"), runtime_error, "manifest:1: --trace cannot be used with --batch");
+        CHECK_EXCEPTION(read_manifest("a.elf --stats=json:stats.json\n"), runtime_error, "manifest:1: --stats with a file cannot be used with --batch");
+    }
+
+    BOOST_AUTO_TEST_CASE(pack)
+    {
+        auto directory = std::filesystem::temp_directory_path() / "shrinklergbacore_batch_packer_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        auto input = std::filesystem::path(SHRINKLERGBACORE_UNITTEST_TESTDATA_DIRECTORY) / "lostmarbles.elf";
+        {
+            std::ofstream manifest(directory / "manifest");
+            manifest << '"' << input.string() << "\" -p1 -o \"" << (directory / "a.gba").string() << "\"\n";
+            manifest << '"' << input.string() << "\" -p1 -o \"" << (directory / "b.gba").string() << "\"\n";
+        }
+        options options;
+        options.batch_file(directory / "manifest");
+        options.jobs(2);
+
+        batch_packer testee;
+        testee.pack(options);
+
+        auto a = load_binary_file(directory / "a.gba");
+        auto b = load_binary_file(directory / "b.gba");
+        BOOST_TEST(a.size() > 0u);
+        BOOST_TEST(a == b, boost::test_tools::per_element());
+        std::filesystem::remove_all(directory);
+    }
+
+    BOOST_AUTO_TEST_CASE(pack_reports_failed_files)
+    {
+        auto directory = std::filesystem::temp_directory_path() / "shrinklergbacore_batch_packer_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+        {
+            std::ofstream manifest(directory / "manifest");
+            manifest << '"' << (directory / "missing.elf").string() << "\"\n";
+        }
+        options options;
+        options.batch_file(directory / "manifest");
+
+        batch_packer testee;
+        CHECK_EXCEPTION(testee.pack(options), runtime_error, "1 of 1 files could not be packed");
+        std::filesystem::remove_all(directory);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -15,6 +15,7 @@ namespace shrinklergbacore_unittest
 {
 
 using shrinklergbacore::command_action;
+using shrinklergbacore::stats_format;
 using std::string;
 using std::vector;
 
@@ -135,6 +136,116 @@ BOOST_FIXTURE_TEST_SUITE(command_line_test, command_line_test_fixture)
         BOOST_TEST(options.debug_checks() == true);
     }
 
+    BOOST_AUTO_TEST_CASE(search_option)
+    {
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST(options.search() == false);
+        BOOST_TEST((parse_command_line("input --search") == command_action::process));
+        BOOST_TEST(options.search() == true);
+    }
+
+    BOOST_AUTO_TEST_CASE(range_index_option)
+    {
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().range_index == false);
+        BOOST_TEST((parse_command_line("input --range-index") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().range_index == true);
+    }
+
+    BOOST_AUTO_TEST_CASE(block_size_option)
+    {
+        BOOST_TEST((parse_command_line("input --block-size=999") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --block-size=x") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().parse_block_size == 0);
+        BOOST_TEST((parse_command_line("input --block-size=65536") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().parse_block_size == 65536);
+    }
+
+    BOOST_AUTO_TEST_CASE(chains_option)
+    {
+        BOOST_TEST((parse_command_line("input --chains=0") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --chains=65") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().chains == 1);
+        BOOST_TEST((parse_command_line("input --chains=4") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().chains == 4);
+    }
+
+    BOOST_AUTO_TEST_CASE(batch_option)
+    {
+        BOOST_TEST((parse_command_line("--batch=manifest") == command_action::process));
+        BOOST_TEST(options.batch_file() == "manifest");
+        BOOST_TEST(options.input_file() == "");
+
+        BOOST_TEST((parse_command_line("input --batch=manifest") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("--batch=manifest -o output") == command_action::exit_failure));
+    }
+
+    BOOST_AUTO_TEST_CASE(cache_options)
+    {
+        BOOST_TEST((parse_command_line("input --cache-size=0") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST(options.cache_directory() == "");
+        BOOST_TEST(options.cache_size() == 1073741824u);
+        BOOST_TEST((parse_command_line("input --cache=dir --cache-size=16") == command_action::process));
+        BOOST_TEST(options.cache_directory() == "dir");
+        BOOST_TEST(options.cache_size() == 16777216u);
+    }
+
+    BOOST_AUTO_TEST_CASE(statistics_options)
+    {
+        BOOST_TEST((parse_command_line("input --stats=csv") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --stats") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --stats=json:") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --stats=csv:stats.csv") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST((options.stats() == stats_format::none));
+        BOOST_TEST(options.trace_file() == "");
+        BOOST_TEST((parse_command_line("input --stats=json --trace=trace.json") == command_action::process));
+        BOOST_TEST((options.stats() == stats_format::json));
+        BOOST_TEST(options.stats_file() == "");
+        BOOST_TEST(options.trace_file() == "trace.json");
+        BOOST_TEST((parse_command_line("input --stats=json:stats.json") == command_action::process));
+        BOOST_TEST((options.stats() == stats_format::json));
+        BOOST_TEST(options.stats_file() == "stats.json");
+    }
+
+    BOOST_AUTO_TEST_CASE(time_budget_option)
+    {
+        BOOST_TEST((parse_command_line("input --time-budget=0") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --time-budget=x") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input --time-budget=2.5") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().time_budget == 2.5);
+    }
+
+    BOOST_AUTO_TEST_CASE(convergence_option)
+    {
+        BOOST_TEST((parse_command_line("input --convergence=-1") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input --convergence=") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input --convergence=0.1") == command_action::process));
+        BOOST_TEST(options.shrinkler_parameters().convergence_threshold == 0.1);
+    }
+
+    BOOST_AUTO_TEST_CASE(jobs_option)
+    {
+        BOOST_TEST((parse_command_line("input -j 0") == command_action::exit_failure));
+        BOOST_TEST((parse_command_line("input -j x") == command_action::exit_failure));
+
+        BOOST_TEST((parse_command_line("input") == command_action::process));
+        BOOST_TEST(options.jobs() == 0u);
+        BOOST_TEST((parse_command_line("input -j 16") == command_action::process));
+        BOOST_TEST(options.jobs() == 16u);
+        BOOST_TEST((parse_command_line("input --jobs=4") == command_action::process));
+        BOOST_TEST(options.jobs() == 4u);
+    }
+
     BOOST_AUTO_TEST_CASE(shrinkler_iterations_option)
     {
         BOOST_TEST((parse_command_line("input -i") == command_action::exit_failure));
@@ -0,0 +1,251 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <boost/test/unit_test.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+#include "shrinklergbacore/compression_cache.hpp"
+#include "shrinklergbacore/gba_packer.hpp"
+#include "shrinklergbacore/options.hpp"
+#include "shrinklergbacore_unittest_config.hpp"
+#include "test_utilities.hpp"
+
+namespace shrinklergbacore_unittest
+{
+
+using shrinklergbacore::compression_cache;
+using shrinklerwrapper::shrinkler_parameters;
+
+class cache_directory_fixture
+{
+public:
+    cache_directory_fixture()
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    ~cache_directory_fixture()
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    size_t entry_count() const
+    {
+        auto entries = std::filesystem::directory_iterator(directory);
+        return std::distance(begin(entries), end(entries));
+    }
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "shrinklergbacore_compression_cache_test";
+};
+
+BOOST_FIXTURE_TEST_SUITE(compression_cache_test, cache_directory_fixture)
+
+    BOOST_AUTO_TEST_CASE(key_depends_on_data_and_parameters_affecting_output)
+    {
+        const std::vector<unsigned char> data{ 1, 2, 3 };
+        const auto key = compression_cache::key(data, shrinkler_parameters(3));
+
+        BOOST_TEST(key.size() == 64u);
+        BOOST_TEST(key == compression_cache::key(data, shrinkler_parameters(3)));
+        BOOST_TEST(key != compression_cache::key(std::vector<unsigned char>{ 1, 2, 4 }, shrinkler_parameters(3)));
+        BOOST_TEST(key != compression_cache::key(data, shrinkler_parameters(4)));
+
+        shrinkler_parameters p(3);
+        p.references = 200000;
+        BOOST_TEST(key != compression_cache::key(data, p));
+        p = shrinkler_parameters(3);
+        p.chains = 2;
+        BOOST_TEST(key != compression_cache::key(data, p));
+
+        p = shrinkler_parameters(3);
+        p.threads = 8;
+        p.verbose = true;
+        BOOST_TEST(key == compression_cache::key(data, p));
+    }
+
+    BOOST_AUTO_TEST_CASE(store_and_load)
+    {
+        compression_cache testee(directory, 1000);
+        const std::vector<unsigned char> compressed{ 4, 5, 6, 7 };
+
+        BOOST_TEST(!testee.load("a").has_value());
+        BOOST_TEST(testee.store("a", compressed));
+        auto loaded = testee.load("a");
+
+        BOOST_TEST(loaded.has_value());
+        BOOST_TEST(*loaded == compressed, boost::test_tools::per_element());
+        BOOST_TEST(entry_count() == 1u);
+    }
+
+    BOOST_AUTO_TEST_CASE(damaged_entry_is_a_miss)
+    {
+        compression_cache testee(directory, 1000);
+        testee.store("a", { 4, 5, 6, 7 });
+        std::filesystem::resize_file(directory / "a.sgc", 10);
+
+        BOOST_TEST(!testee.load("a").has_value());
+    }
+
+    BOOST_AUTO_TEST_CASE(entry_with_changed_data_is_a_miss)
+    {
+        compression_cache testee(directory, 1000);
+        testee.store("a", { 4, 5, 6, 7 });
+        {
+            std::fstream file(directory / "a.sgc", std::ios::in | std::ios::out | std::ios::binary);
+            file.seekp(-1, std::ios::end);
+            file.put(8);
+        }
+
+        BOOST_TEST(!testee.load("a").has_value());
+    }
+
+    BOOST_AUTO_TEST_CASE(least_recently_used_entries_are_evicted)
+    {
+        // Each entry is 40 header bytes plus 100 data bytes, so only two entries fit.
+        compression_cache testee(directory, 350);
+        const std::vector<unsigned char> compressed(100, 0);
+        const auto now = std::filesystem::file_time_type::clock::now();
+        testee.store("a", compressed);
+        std::filesystem::last_write_time(directory / "a.sgc", now - std::chrono::hours(2));
+        testee.store("b", compressed);
+        std::filesystem::last_write_time(directory / "b.sgc", now - std::chrono::hours(1));
+
+        testee.load("a");
+        testee.store("c", compressed);
+
+        BOOST_TEST(testee.load("a").has_value());
+        BOOST_TEST(!testee.load("b").has_value());
+        BOOST_TEST(testee.load("c").has_value());
+    }
+
+    BOOST_AUTO_TEST_CASE(entry_bigger_than_cache_is_kept)
+    {
+        compression_cache testee(directory, 50);
+        const std::vector<unsigned char> compressed(100, 0);
+
+        testee.store("a", compressed);
+        testee.store("b", compressed);
+
+        BOOST_TEST(!testee.load("a").has_value());
+        BOOST_TEST(testee.load("b").has_value());
+    }
+
+    BOOST_AUTO_TEST_CASE(stale_temporary_files_are_removed)
+    {
+        compression_cache testee(directory, 1000);
+        std::filesystem::create_directories(directory);
+        const auto now = std::filesystem::file_time_type::clock::now();
+        std::ofstream(directory / "x.sgc.0123456789abcdef.tmp") << "stale";
+        std::filesystem::last_write_time(directory / "x.sgc.0123456789abcdef.tmp", now - std::chrono::hours(2));
+        std::ofstream(directory / "y.sgc.0123456789abcdef.tmp") << "in progress";
+
+        testee.store("a", std::vector<unsigned char>(10, 0));
+
+        BOOST_TEST(!std::filesystem::exists(directory / "x.sgc.0123456789abcdef.tmp"));
+        BOOST_TEST(std::filesystem::exists(directory / "y.sgc.0123456789abcdef.tmp"));
+        BOOST_TEST(testee.load("a").has_value());
+    }
+
+    BOOST_AUTO_TEST_CASE(concurrent_writers)
+    {
+        compression_cache testee(directory, 1000000);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 8; ++i)
+        {
+            threads.emplace_back([&testee, i]()
+            {
+                for (int j = 0; j < 20; ++j)
+                {
+                    testee.store(std::to_string(j % 4), std::vector<unsigned char>(1000 + j % 4, static_cast<unsigned char>(j % 4)));
+                }
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        BOOST_TEST(entry_count() == 4u);
+        for (int j = 0; j < 4; ++j)
+        {
+            auto loaded = testee.load(std::to_string(j));
+            BOOST_TEST(loaded.has_value());
+            BOOST_TEST(*loaded == std::vector<unsigned char>(1000 + j, static_cast<unsigned char>(j)), boost::test_tools::per_element());
+        }
+    }
+
+    BOOST_AUTO_TEST_CASE(gba_packer_uses_cache)
+    {
+        shrinklergbacore::options options;
+        options.input_file(std::filesystem::path(SHRINKLERGBACORE_UNITTEST_TESTDATA_DIRECTORY) / "lostmarbles.elf");
+        options.output_file(directory / "a.gba");
+        options.cache_directory(directory / "cache");
+        options.shrinkler_parameters().preset(1);
+        shrinklergbacore::gba_packer packer;
+
+        packer.pack(options);
+        std::vector<std::filesystem::path> entries;
+        for (const auto& entry : std::filesystem::directory_iterator(directory / "cache"))
+        {
+            BOOST_TEST(entry.path().extension() == ".sgc");
+            entries.push_back(entry.path());
+        }
+        BOOST_REQUIRE(entries.size() == 1u);
+
+        // Replace the entry with different data. Packing again must use it instead of compressing.
+        compression_cache cache(directory / "cache", options.cache_size());
+        const auto key = entries[0].stem().string();
+        auto compressed_program = cache.load(key).value();
+        compressed_program.insert(compressed_program.end(), { 'T', 'o', 'm', '!' });
+        cache.store(key, compressed_program);
+        options.output_file(directory / "b.gba");
+        packer.pack(options);
+
+        const auto a = load_binary_file(directory / "a.gba");
+        const auto b = load_binary_file(directory / "b.gba");
+        BOOST_TEST(b.size() > a.size());
+        BOOST_TEST((std::search(b.begin(), b.end(), compressed_program.begin(), compressed_program.end()) != b.end()));
+    }
+
+    BOOST_AUTO_TEST_CASE(results_depending_on_time_are_not_cacheable)
+    {
+        shrinkler_parameters p(3);
+        BOOST_TEST(compression_cache::cacheable(p));
+
+        p.time_budget = 10;
+        BOOST_TEST(!compression_cache::cacheable(p));
+
+        std::stop_source stop_source;
+        p = shrinkler_parameters(3);
+        p.stop_token = stop_source.get_token();
+        BOOST_TEST(compression_cache::cacheable(p));
+        stop_source.request_stop();
+        BOOST_TEST(!compression_cache::cacheable(p));
+    }
+
+    BOOST_AUTO_TEST_CASE(gba_packer_does_not_cache_with_time_budget)
+    {
+        shrinklergbacore::options options;
+        options.input_file(std::filesystem::path(SHRINKLERGBACORE_UNITTEST_TESTDATA_DIRECTORY) / "lostmarbles.elf");
+        options.output_file(directory / "a.gba");
+        options.cache_directory(directory / "cache");
+        options.shrinkler_parameters().preset(1);
+        options.shrinkler_parameters().time_budget = 1000;
+        shrinklergbacore::gba_packer packer;
+        std::filesystem::create_directories(directory);
+
+        packer.pack(options);
+
+        BOOST_TEST(!std::filesystem::exists(directory / "cache"));
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <boost/test/unit_test.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <vector>
+#include "shrinklerwrapper/shrinklerwrapper.hpp"
+#include "test_utilities.hpp"
+
+namespace shrinklergbacore_unittest
+{
+
+using shrinklerwrapper::shrinkler_compressor;
+using shrinklerwrapper::shrinkler_input;
+using shrinklerwrapper::shrinkler_parameters;
+
+namespace
+{
+
+// 64 bit FNV-1a
+uint64_t fnv1a(const std::vector<unsigned char>& data)
+{
+    uint64_t hash = 0xcbf29ce484222325;
+    for (auto c : data)
+    {
+        hash = (hash ^ c) * 0x100000001b3;
+    }
+    return hash;
+}
+
+struct golden_result
+{
+    int preset;
+    bool parity_context;
+    int references;
+    size_t size;
+    uint64_t hash;
+};
+
+// Compressed data produced by Shrinkler as originally ported.
+// Optimizations of the compressor must not change it.
+const golden_result golden_results[] =
+{
+    { 1, true, 100000, 2780, 0xbb53dd2986ee7dfc },
+    { 3, true, 100000, 2720, 0xf26b012cfa8200d2 },
+    { 9, true, 100000, 2712, 0xe5dbc8290fe8602f },
+    { 1, false, 100000, 2828, 0xc68d8c25ca68ff92 },
+    { 3, false, 100000, 2752, 0xf5eef757d08da583 },
+    { 9, false, 100000, 2748, 0x5a744205b096cd92 },
+    // Few references, so that edges are cleaned
+    { 3, true, 1000, 2720, 0x3c46af4598520235 },
+    { 9, false, 1000, 2748, 0x060c0d7ad57ea79c }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE(compression_golden_test)
+
+    BOOST_AUTO_TEST_CASE(lostmarbles)
+    {
+        const shrinkler_input input(load_binary_file("lostmarbles.bin"));
+
+        for (const auto& golden : golden_results)
+        {
+            shrinkler_parameters parameters(golden.preset);
+            parameters.parity_context = golden.parity_context;
+            parameters.references = golden.references;
+            shrinkler_compressor compressor;
+            compressor.set_parameters(parameters);
+
+            const auto result = compressor.compress(input, nullptr, nullptr);
+
+            BOOST_TEST_CONTEXT(std::format("-p{} parity context {} -r{}", golden.preset, golden.parity_context, golden.references))
+            {
+                BOOST_TEST(result.data.size() == golden.size);
+                BOOST_TEST(fnv1a(result.data) == golden.hash);
+                if (golden.references < 100000)
+                {
+                    BOOST_TEST(result.counters.edges_cleaned > 0);
+                }
+            }
+        }
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <boost/test/unit_test.hpp>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include "shrinklergbacore/pack_statistics.hpp"
+
+namespace shrinklergbacore_unittest
+{
+
+using shrinklergbacore::pack_statistics;
+using std::chrono::milliseconds;
+
+BOOST_AUTO_TEST_SUITE(pack_statistics_test)
+
+    BOOST_AUTO_TEST_CASE(add_counter_accumulates_in_order_of_first_addition)
+    {
+        pack_statistics testee;
+
+        testee.add_counter("b", 1);
+        testee.add_counter("a", 2);
+        testee.add_counter("b", 3);
+
+        BOOST_TEST(testee.counters().size() == 2u);
+        BOOST_TEST(testee.counters()[0].first == "b");
+        BOOST_TEST(testee.counters()[0].second == 4);
+        BOOST_TEST(testee.counters()[1].first == "a");
+        BOOST_TEST(testee.counters()[1].second == 2);
+    }
+
+    BOOST_AUTO_TEST_CASE(add_compression_result)
+    {
+        shrinklerwrapper::compression_result result;
+        result.references_considered = 10;
+        result.pass_sizes = { 1.0, 2.0 };
+        result.counters.matches = 5;
+        result.phases.push_back({ .name = "parse", .chain = 0, .pass = 1 });
+        pack_statistics testee;
+
+        testee.add(result);
+        testee.add(result);
+
+        BOOST_TEST(testee.phases().size() == 2u);
+        BOOST_TEST(testee.phases()[0].name == "parse");
+        BOOST_TEST(testee.counters()[0].first == "matches");
+        BOOST_TEST(testee.counters()[0].second == 10);
+        BOOST_TEST(testee.counters()[4].first == "references_considered");
+        BOOST_TEST(testee.counters()[4].second == 20);
+        BOOST_TEST(testee.counters()[6].first == "passes");
+        BOOST_TEST(testee.counters()[6].second == 4);
+    }
+
+    BOOST_AUTO_TEST_CASE(write_json)
+    {
+        pack_statistics testee;
+        const auto begin = pack_statistics::clock::now();
+        testee.add_phase("load", begin, begin + milliseconds(250));
+        testee.add_phase("load", begin, begin + milliseconds(500));
+        testee.add(shrinklerwrapper::compression_result{ .phases = { { .name = "parse", .chain = 1, .pass = 0, .begin = begin, .end = begin } } });
+        testee.add_counter("cart_size", 1234);
+        testee.add_counter("say \"hi\"", 1);
+        std::ostringstream json;
+
+        testee.write_json(json);
+
+        BOOST_TEST(json.str().starts_with("{\n  \"total_seconds\": "));
+        BOOST_TEST(json.str().find("{\"name\": \"parse\", \"chain\": 2, \"pass\": 1, \"start_seconds\": ") != std::string::npos);
+        BOOST_TEST(json.str().find("\"load\": 0.750000") != std::string::npos);
+        BOOST_TEST(json.str().find("\"cart_size\": 1234") != std::string::npos);
+        BOOST_TEST(json.str().find("\"say \\\"hi\\\"\": 1") != std::string::npos);
+    }
+
+    BOOST_AUTO_TEST_CASE(write_chrome_trace)
+    {
+        pack_statistics testee;
+        const auto begin = pack_statistics::clock::now();
+        testee.add_phase("load", begin, begin + milliseconds(2));
+        testee.add(shrinklerwrapper::compression_result{ .phases = { { .name = "parse", .chain = 1, .pass = 2, .begin = begin, .end = begin + milliseconds(1) } } });
+        std::ostringstream trace;
+
+        testee.write_chrome_trace(trace);
+
+        BOOST_TEST(trace.str().find("\"traceEvents\": [") != std::string::npos);
+        BOOST_TEST(trace.str().find("\"tid\": 2, \"args\": {\"name\": \"Chain 2\"}") != std::string::npos);
+        BOOST_TEST(trace.str().find("{\"name\": \"load\", \"ph\": \"X\", \"pid\": 1, \"tid\": 0, ") != std::string::npos);
+        BOOST_TEST(trace.str().find("\"dur\": 2000.000") != std::string::npos);
+        BOOST_TEST(trace.str().find("{\"name\": \"parse\", \"ph\": \"X\", \"pid\": 1, \"tid\": 2, ") != std::string::npos);
+        BOOST_TEST(trace.str().find("\"dur\": 1000.000, \"args\": {\"pass\": 3}}") != std::string::npos);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <boost/test/unit_test.hpp>
+#include <cstring>
+#include <vector>
+#include "shrinklergbacore/parameter_search.hpp"
+
+namespace shrinklergbacore_unittest
+{
+
+using namespace shrinklergbacore;
+using shrinklerwrapper::shrinkler_parameters;
+
+BOOST_AUTO_TEST_SUITE(parameter_search_test)
+
+    BOOST_AUTO_TEST_CASE(make_search_grid_keeps_references_and_parity_context)
+    {
+        shrinkler_parameters base;
+        base.references = 123456;
+        base.parity_context = false;
+
+        auto grid = make_search_grid(base);
+
+        BOOST_TEST(grid.size() == 36u);
+        for (const auto& p : grid)
+        {
+            BOOST_TEST(p.references == 123456);
+            BOOST_TEST(p.parity_context == false);
+        }
+        BOOST_TEST(grid.front().iterations == 1);
+        BOOST_TEST(grid.front().effort == 100);
+        BOOST_TEST(grid.front().same_length == 10);
+        BOOST_TEST(grid.back().iterations == 9);
+        BOOST_TEST(grid.back().effort == 3600);
+        BOOST_TEST(grid.back().same_length == 360);
+    }
+
+    BOOST_AUTO_TEST_CASE(make_search_grid_does_not_vary_effort_with_range_index)
+    {
+        shrinkler_parameters base;
+        base.range_index = true;
+
+        auto grid = make_search_grid(base);
+
+        BOOST_TEST(grid.size() == 18u);
+        for (const auto& p : grid)
+        {
+            BOOST_TEST(p.range_index == true);
+        }
+        BOOST_TEST(grid.back().effort == 900);
+        BOOST_TEST(grid.back().same_length == 360);
+    }
+
+    BOOST_AUTO_TEST_CASE(run_returns_smallest_result)
+    {
+        const char* s = "foo foo foo foo";
+        std::vector<unsigned char> data(s, s + std::strlen(s));
+        std::vector<shrinkler_parameters> grid{ shrinkler_parameters(1), shrinkler_parameters(9), shrinkler_parameters(2) };
+
+        console silent_console;
+        silent_console.verbose(nullptr);
+        parameter_search testee(silent_console, 2);
+        auto result = testee.run(data, grid, [](const std::vector<unsigned char>& compressed_data) { return compressed_data.size(); });
+
+        // All parameter sets give the same size, so the first one must win.
+        BOOST_TEST(result.cart_size == 8u);
+        BOOST_TEST(result.parameters.iterations == 1);
+        BOOST_TEST(result.compressed_data.size() == 8u);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -0,0 +1,53 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <boost/test/unit_test.hpp>
+#include <string>
+#include <vector>
+#include "shrinklergbacore/sha256.hpp"
+
+namespace shrinklergbacore_unittest
+{
+
+using shrinklergbacore::sha256;
+
+static std::string hash(const std::string& s)
+{
+    sha256 h;
+    h.update(s);
+    return sha256::to_string(h.finish());
+}
+
+BOOST_AUTO_TEST_SUITE(sha256_test)
+
+    BOOST_AUTO_TEST_CASE(empty_input)
+    {
+        BOOST_TEST(hash("") == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+    }
+
+    BOOST_AUTO_TEST_CASE(one_block)
+    {
+        BOOST_TEST(hash("abc") == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+    }
+
+    BOOST_AUTO_TEST_CASE(two_blocks)
+    {
+        BOOST_TEST(hash("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") == "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+    }
+
+    BOOST_AUTO_TEST_CASE(input_split_into_pieces)
+    {
+        const std::vector<unsigned char> a(1000000, 'a');
+        sha256 h;
+        for (size_t i = 0; i < a.size(); i += 999)
+        {
+            h.update(std::span(a).subspan(i, std::min<size_t>(999, a.size() - i)));
+        }
+
+        BOOST_TEST(sha256::to_string(h.finish()) == "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
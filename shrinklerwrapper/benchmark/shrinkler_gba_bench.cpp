@@ -0,0 +1,594 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+// Micro-benchmarks of the hot paths of Shrinkler's cruncher.
+// Usage: shrinkler_gba_bench [--filter=TEXT] [--min-time=SECONDS] [--threads=N] [files...]
+// Without files, the test data and a set of synthetic inputs of increasing size are used.
+// Results are written to stdout as JSON, progress to stderr.
+// Each benchmark is repeated until it has run for at least --min-time seconds.
+// Benchmarks which have a reference implementation check their results against it once before measuring.
+// The block_parse benchmarks also report how much larger the result gets by parsing in blocks,
+// e.g. shrinkler_gba_bench --filter=block_parse --min-time=0
+
+#include "../src/shrinkler.ipp"
+#include "../include/shrinklerwrapper/json.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+using std::string;
+using std::vector;
+
+// Parameters of the LZ parser, as used by preset 3.
+constexpr int bench_preset = 3;
+constexpr int bench_match_patience = 100 * bench_preset;
+constexpr int bench_max_same_length = 10 * bench_preset;
+constexpr int bench_length_margin = 1 * bench_preset;
+constexpr int bench_skip_length = 1000 * bench_preset;
+constexpr int bench_references = 100000;
+
+struct benchmark_input
+{
+    string name;
+    vector<unsigned char> data;
+};
+
+struct bench_options
+{
+    string filter;
+    double min_time = 0.5;
+    int threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    vector<string> files;
+};
+
+vector<unsigned char> load_file(const std::filesystem::path& filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Could not open " + filename.string());
+    }
+    return vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Random literals, repeated snippets and zero runs, roughly resembling code and data of an intro.
+vector<unsigned char> make_synthetic_data(size_t size)
+{
+    vector<unsigned char> data;
+    uint32_t seed = 1;
+    auto next = [&]() { seed = seed * 1103515245 + 12345; return seed >> 8; };
+
+    while (data.size() < size)
+    {
+        auto kind = next() % 8;
+        if ((kind < 4) || (data.size() < 64))
+        {
+            data.push_back(next() & 0xff);
+        }
+        else if (kind < 7)
+        {
+            auto start = next() % data.size();
+            auto length = 4 + next() % 60;
+            for (size_t i = 0; (i < length) && (start + i < data.size()); ++i)
+            {
+                data.push_back(data[start + i]);
+            }
+        }
+        else
+        {
+            data.insert(data.end(), next() % 256, 0);
+        }
+    }
+
+    data.resize(size);
+    return data;
+}
+
+// Kasai's algorithm, as used by SuffixIndex before computeLongestCommonPrefix.
+vector<int> kasai_lcp(const vector<unsigned char>& data, const vector<int>& suffix_array)
+{
+    const int length = static_cast<int>(data.size());
+    vector<int> rank(length + 1);
+    for (int r = 0; r <= length; ++r)
+    {
+        rank[suffix_array[r]] = r;
+    }
+
+    vector<int> lcp(length + 1, 0);
+    int h = 0;
+    for (int i = 0; i < length; ++i)
+    {
+        int r = rank[i];
+        if (r < length)
+        {
+            int j = suffix_array[r + 1];
+            int m = length - std::max(i, j);
+            while ((h < m) && (data[i + h] == data[j + h]))
+            {
+                ++h;
+            }
+            lcp[r] = h;
+            if (h > 0)
+            {
+                --h;
+            }
+        }
+    }
+    return lcp;
+}
+
+// Distances to the previous occurrence of the three bytes at each position, i.e. the offsets the parser
+// typically looks up. Used as keys by the hash table and heap benchmarks.
+// Trigrams are hashed, so occasionally the distance to a different trigram is used, which does not matter here.
+vector<int> make_offsets(const vector<unsigned char>& data)
+{
+    vector<int> last(1 << 16, -1);
+    vector<int> offsets;
+    for (size_t i = 0; i + 2 < data.size(); ++i)
+    {
+        const int trigram = (((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u) >> 16;
+        const int pos = static_cast<int>(i);
+        offsets.push_back(last[trigram] < 0 ? pos + 1 : pos - last[trigram]);
+        last[trigram] = pos;
+    }
+    return offsets;
+}
+
+// Keys are looked up in windows of this many keys, like the parser's per position tables.
+constexpr size_t hash_window = 1024;
+
+// Element type for the heap benchmark. Heap requires a pointer type with an _heap_index field.
+struct heap_node
+{
+    int _heap_index = 0;
+};
+
+// Parse state for the parse and range coder benchmarks.
+// Parsing starts from a model trained by one pass, so that the measured passes resemble the later passes of a compression.
+class parse_fixture final
+{
+public:
+    explicit parse_fixture(const benchmark_input& input, int threads)
+        : data(input.data.data()),
+          length(static_cast<int>(input.data.size())),
+          index(data, length, threads),
+          finder(index, 2, bench_match_patience, bench_max_same_length),
+          edge_factory(bench_references),
+          parser(data, length, 0, finder, bench_length_margin, bench_skip_length, &edge_factory),
+          counting_coder(std::make_unique<CountingCoder>(LZEncoder::NUM_CONTEXTS))
+    {
+        // Train the model the same way the compressor does after each pass.
+        result = parse();
+        CountingCoder new_counting_coder(LZEncoder::NUM_CONTEXTS);
+        result.encode(SpecializedLZEncoder<CountingCoder, true>(counting_coder.get()));
+        counting_coder = std::make_unique<CountingCoder>(counting_coder.get(), &new_counting_coder);
+    }
+
+    LZParseResult parse()
+    {
+        SizeMeasuringCoder measurer(counting_coder.get());
+        measurer.setNumberContexts(LZEncoder::NUMBER_CONTEXT_OFFSET, LZEncoder::NUM_NUMBER_CONTEXTS, length);
+        SilentProgress progress;
+        finder.reset();
+        return parser.parse(MeasuringLZEncoder<true>(&measurer), &progress);
+    }
+
+    // Parses like parse, but in blocks, as with --block-size.
+    LZParseResult parse(BlockParser& block_parser)
+    {
+        SizeMeasuringCoder measurer(counting_coder.get());
+        measurer.setNumberContexts(LZEncoder::NUMBER_CONTEXT_OFFSET, LZEncoder::NUM_NUMBER_CONTEXTS, length);
+        SilentProgress progress;
+        return block_parser.parse(MeasuringLZEncoder<true>(&measurer), &progress);
+    }
+
+    // Size of a parse result in bytes after adaptive range coding, as reported for each pass by the compressor.
+    static double encoded_size(const LZParseResult& parse_result)
+    {
+        vector<unsigned> out;
+        RangeCoder range_coder(LZEncoder::NUM_CONTEXTS, out);
+        const auto size = parse_result.encode(SpecializedLZEncoder<RangeCoder, true>(&range_coder));
+        range_coder.finish();
+        return size / static_cast<double>(8 << Coder::BIT_PRECISION);
+    }
+
+    const SuffixIndex& suffix_index() const { return index; }
+
+    const LZParseResult& last_result() const { return result; }
+
+private:
+    const unsigned char* data;
+    int length;
+    SuffixIndex index;
+    MatchFinder finder;
+    RefEdgeFactory edge_factory;
+    LZParser parser;
+    std::unique_ptr<CountingCoder> counting_coder;
+    LZParseResult result;
+};
+
+class benchmark_runner final
+{
+public:
+    explicit benchmark_runner(const bench_options& options) : m_options(options) {}
+
+    bool enabled(std::string_view benchmark) const
+    {
+        return benchmark.find(m_options.filter) != std::string_view::npos;
+    }
+
+    // Runs f repeatedly. f returns the number of items it processed, e.g. matches found or hash table operations.
+    // If given, report is called afterwards and returns additional JSON fields for the result.
+    void run(std::string_view benchmark, const benchmark_input& input, const std::function<uint64_t()>& f, const std::function<string()>& report = nullptr)
+    {
+        if (!enabled(benchmark))
+        {
+            return;
+        }
+
+        std::cerr << std::format("{} {}", benchmark, input.name) << std::endl;
+        uint64_t iterations = 0;
+        uint64_t items = 0;
+        double total = 0;
+        double fastest = 0;
+        do
+        {
+            const auto start = std::chrono::steady_clock::now();
+            items = f();
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            fastest = iterations ? std::min(fastest, seconds) : seconds;
+            total += seconds;
+            ++iterations;
+        }
+        while (total < m_options.min_time);
+
+        const double mean = total / iterations;
+        m_results.push_back(std::format(
+            "    {{\"name\": \"{}\", \"input\": \"{}\", \"size\": {}, \"iterations\": {}, \"mean_seconds\": {:.9g}, \"min_seconds\": {:.9g}, "
+            "\"bytes_per_second\": {:.9g}, \"items\": {}, \"items_per_second\": {:.9g}{}}}",
+            shrinklerwrapper::escape_json(benchmark), shrinklerwrapper::escape_json(input.name), input.data.size(), iterations, mean, fastest,
+            input.data.size() / mean, items, items / mean, report ? ", " + report() : string()));
+    }
+
+    void write_json(std::ostream& out) const
+    {
+        out << "{\n";
+        out << std::format("  \"context\": {{\"threads\": {}, \"min_time\": {:.9g}, \"preset\": {}}},\n", m_options.threads, m_options.min_time, bench_preset);
+        out << "  \"benchmarks\": [\n";
+        for (size_t i = 0; i < m_results.size(); ++i)
+        {
+            out << m_results[i] << (i + 1 < m_results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n";
+        out << "}" << std::endl;
+    }
+
+private:
+    const bench_options& m_options;
+    vector<string> m_results;
+};
+
+void bench_suffix_array(benchmark_runner& runner, const benchmark_input& input, int threads)
+{
+    // Same string with virtual sentinel as used by SuffixIndex.
+    const int length = static_cast<int>(input.data.size()) + 1;
+    SentinelByteString data(input.data.data(), length - 1);
+    SuffixArrayWorkspace workspace;
+    workspace.reserve(suffixArrayWorkspaceSize(length, 257));
+
+    vector<int> expected(length);
+    vector<int> actual(length);
+    computeSuffixArray(data, expected.data(), length, 257, workspace);
+    computeSuffixArrayParallel(data, actual.data(), length, 257, threads, workspace);
+    if (actual != expected)
+    {
+        throw std::runtime_error("Suffix arrays differ for " + input.name);
+    }
+
+    runner.run("suffix_array", input, [&]()
+    {
+        computeSuffixArray(data, actual.data(), length, 257, workspace);
+        return static_cast<uint64_t>(length);
+    });
+    runner.run("suffix_array_parallel", input, [&]()
+    {
+        computeSuffixArrayParallel(data, actual.data(), length, 257, threads, workspace);
+        return static_cast<uint64_t>(length);
+    });
+
+    if (!runner.enabled("lcp"))
+    {
+        return;
+    }
+
+    const auto expected_lcp = kasai_lcp(input.data, expected);
+    vector<int> plcp(length);
+    vector<int> actual_lcp(length);
+    auto lcp = [&]()
+    {
+        // Like SuffixIndex, compute the reverse suffix array afterwards, since Kasai's algorithm computes it too.
+        computeLongestCommonPrefix(input.data.data(), length - 1, expected.data(), plcp.data(), actual_lcp.data());
+        for (int r = 0; r < length; ++r)
+        {
+            plcp[expected[r]] = r;
+        }
+        return static_cast<uint64_t>(length);
+    };
+    lcp();
+    if (actual_lcp != expected_lcp)
+    {
+        throw std::runtime_error("LCP arrays differ for " + input.name);
+    }
+
+    runner.run("lcp", input, lcp);
+    runner.run("lcp_kasai", input, [&]()
+    {
+        return static_cast<uint64_t>(kasai_lcp(input.data, expected).size());
+    });
+}
+
+void bench_match_finder(benchmark_runner& runner, const benchmark_input& input, int threads)
+{
+    if (!runner.enabled("match_finder"))
+    {
+        return;
+    }
+
+    const int length = static_cast<int>(input.data.size());
+    SuffixIndex index(input.data.data(), length, threads);
+    MatchFinder finder(index, 2, bench_match_patience, bench_max_same_length);
+
+    runner.run("match_finder", input, [&]()
+    {
+        uint64_t matches = 0;
+        int match_pos;
+        int match_length;
+        finder.reset();
+        for (int pos = 0; pos < length; ++pos)
+        {
+            finder.beginMatching(pos);
+            while (finder.nextMatch(&match_pos, &match_length))
+            {
+                ++matches;
+            }
+        }
+        return matches;
+    });
+}
+
+void bench_parse(benchmark_runner& runner, const benchmark_input& input, int threads)
+{
+    if (!runner.enabled("parse") && !runner.enabled("range_coder"))
+    {
+        return;
+    }
+
+    parse_fixture fixture(input, threads);
+
+    runner.run("parse", input, [&]()
+    {
+        fixture.parse();
+        return static_cast<uint64_t>(input.data.size());
+    });
+
+    // Encodes the parse result, which is what the compressor uses RangeCoder::code for.
+    vector<unsigned> out;
+    runner.run("range_coder", input, [&]()
+    {
+        RangeCoder range_coder(LZEncoder::NUM_CONTEXTS, out);
+        fixture.last_result().encode(SpecializedLZEncoder<RangeCoder, true>(&range_coder));
+        range_coder.finish();
+        return static_cast<uint64_t>(out.size() * 4);
+    });
+}
+
+template <typename Table>
+uint64_t exercise_hash_table(Table& table, const vector<int>& keys)
+{
+    uint64_t operations = 0;
+    uint64_t found = 0;
+    for (size_t begin = 0; begin < keys.size(); begin += hash_window)
+    {
+        const size_t end = std::min(keys.size(), begin + hash_window);
+        for (size_t i = begin; i < end; ++i)
+        {
+            table[keys[i]] = static_cast<int>(i);
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            found += table.find(keys[i]) != nullptr;
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            table.erase(keys[i]);
+        }
+        operations += 3 * (end - begin);
+    }
+
+    if (!table.empty() || (found != keys.size()))
+    {
+        throw std::runtime_error("Hash table benchmark gave an inconsistent result");
+    }
+    return operations;
+}
+
+// Size lost by parsing in blocks, compared to parsing all data at once.
+// Both parses use the same model, trained by one pass over all data, so the difference is due to the seams only.
+void bench_block_parse(benchmark_runner& runner, const benchmark_input& input, int threads)
+{
+    if (!runner.enabled("block_parse"))
+    {
+        return;
+    }
+
+    parse_fixture fixture(input, threads);
+    const double whole_size = parse_fixture::encoded_size(fixture.parse());
+    for (int block_size : { 16384, 4096, 1000 })
+    {
+        if (input.data.size() <= static_cast<size_t>(block_size))
+        {
+            continue;
+        }
+
+        BlockParser block_parser(input.data.data(), static_cast<int>(input.data.size()), 0, fixture.suffix_index(), bench_match_patience, bench_max_same_length, false,
+            bench_length_margin, bench_skip_length, bench_references, nullptr, block_size, threads);
+        LZParseResult result;
+        const auto benchmark = std::format("block_parse_{}", block_size);
+        runner.run(benchmark, input, [&]()
+        {
+            result = fixture.parse(block_parser);
+            return static_cast<uint64_t>(input.data.size());
+        },
+        [&]()
+        {
+            const double blocked_size = parse_fixture::encoded_size(result);
+            const double loss = blocked_size - whole_size;
+            std::cerr << std::format("{} {}: {:.3f} -> {:.3f} bytes ({:+.3f}, {:+.4f}%)", benchmark, input.name, whole_size, blocked_size, loss, 100 * loss / whole_size) << std::endl;
+            return std::format("\"whole_bytes\": {:.3f}, \"blocked_bytes\": {:.3f}, \"loss_bytes\": {:.3f}", whole_size, blocked_size, loss);
+        });
+    }
+}
+
+void bench_containers(benchmark_runner& runner, const benchmark_input& input)
+{
+    if (!runner.enabled("cuckoo_hash") && !runner.enabled("swiss_hash") && !runner.enabled("heap"))
+    {
+        return;
+    }
+
+    const auto offsets = make_offsets(input.data);
+
+    runner.run("cuckoo_hash", input, [&]()
+    {
+        CuckooHash<int> table;
+        return exercise_hash_table(table, offsets);
+    });
+    runner.run("swiss_hash", input, [&]()
+    {
+        SwissHash<int> table;
+        return exercise_hash_table(table, offsets);
+    });
+
+    // Same pattern as the parser's root edges: insert, remove some arbitrary elements, then drain from the largest.
+    vector<heap_node> nodes(offsets.size());
+    runner.run("heap", input, [&]()
+    {
+        Heap<heap_node*, int, 2> heap;
+        uint64_t operations = 0;
+        for (size_t i = 0; i < nodes.size(); ++i)
+        {
+            heap.insert(&nodes[i], offsets[i]);
+        }
+        for (size_t i = 0; i < nodes.size(); i += 3)
+        {
+            heap.remove(&nodes[i]);
+            ++operations;
+        }
+        while (heap.size())
+        {
+            heap.remove_largest();
+            ++operations;
+        }
+        return operations + nodes.size();
+    });
+}
+
+bench_options parse_arguments(int argc, char* argv[])
+{
+    bench_options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view argument(argv[i]);
+        if (argument.starts_with("--filter="))
+        {
+            options.filter = argument.substr(9);
+        }
+        else if (argument.starts_with("--min-time="))
+        {
+            options.min_time = std::atof(argv[i] + 11);
+        }
+        else if (argument.starts_with("--threads="))
+        {
+            options.threads = std::max(1, std::atoi(argv[i] + 10));
+        }
+        else if (argument.starts_with("--"))
+        {
+            throw std::runtime_error(std::format("unknown option {}", argument));
+        }
+        else
+        {
+            options.files.push_back(argv[i]);
+        }
+    }
+    return options;
+}
+
+vector<benchmark_input> load_inputs(const bench_options& options)
+{
+    vector<benchmark_input> inputs;
+    for (const auto& file : options.files)
+    {
+        inputs.push_back({ std::filesystem::path(file).filename().string(), load_file(file) });
+    }
+
+    if (inputs.empty())
+    {
+        for (auto name : { "lostmarbles.bin", "thumb_entry.bin" })
+        {
+            inputs.push_back({ name, load_file(std::filesystem::path(SHRINKLER_GBA_BENCH_TESTDATA_DIRECTORY) / name) });
+        }
+        for (size_t size = 16 * 1024; size <= 1024 * 1024; size *= 4)
+        {
+            inputs.push_back({ std::format("synthetic-{}k", size / 1024), make_synthetic_data(size) });
+        }
+    }
+
+    return inputs;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    try
+    {
+        const auto options = parse_arguments(argc, argv);
+        const auto inputs = load_inputs(options);
+
+        benchmark_runner runner(options);
+        for (const auto& input : inputs)
+        {
+            bench_suffix_array(runner, input, options.threads);
+            bench_match_finder(runner, input, options.threads);
+            bench_parse(runner, input, options.threads);
+            bench_block_parse(runner, input, options.threads);
+            bench_containers(runner, input);
+        }
+        runner.write_json(std::cout);
+
+        return EXIT_SUCCESS;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+}
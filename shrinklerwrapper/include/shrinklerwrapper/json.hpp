@@ -0,0 +1,45 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#ifndef SHRINKLERWRAPPER_JSON_HPP
+#define SHRINKLERWRAPPER_JSON_HPP
+
+#include <format>
+#include <string>
+#include <string_view>
+
+namespace shrinklerwrapper
+{
+
+// Escapes s for use inside a JSON string. The quotes around the string are not added.
+// Header only, so that the benchmarks, which compile Shrinkler's code themselves, can use it too.
+inline std::string escape_json(std::string_view s)
+{
+    std::string escaped;
+    for (auto c : s)
+    {
+        switch (c)
+        {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    escaped += std::format("\\u{:04x}", static_cast<unsigned char>(c));
+                }
+                else
+                {
+                    escaped += c;
+                }
+                break;
+        }
+    }
+    return escaped;
+}
+
+}
+
+#endif
@@ -5,10 +5,20 @@
 #ifndef SHRINKLERWRAPPER_SHRINKLERWRAPPER_HPP
 #define SHRINKLERWRAPPER_SHRINKLERWRAPPER_HPP
 
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
 #include <vector>
 
+class SuffixIndex;
+
 namespace shrinklerwrapper
 {
 
@@ -32,6 +42,14 @@ public:
     bool verbose = false;
     bool parity_context = true;
     int references = 100000;
+    int threads = 1;
+    bool precompute_matches = true;
+    bool range_index = false;
+    int parse_block_size = 0; // 0 parses all data at once
+    int chains = 1;
+    double time_budget = 0; // Seconds for compressing a shrinkler_input, 0 for no limit. The first pass of each chain always completes
+    double convergence_threshold = 0; // Stop when a pass gains fewer bytes than this, 0 to always run all iterations
+    std::stop_token stop_token; // When a stop is requested, compression ends as soon as possible and throws compression_cancelled
     int iterations;
     int length_margin;
     int same_length;
@@ -39,10 +57,104 @@ public:
     int skip_length;
 };
 
+// Data to be compressed, along with its suffix array.
+// The suffix array does not depend on compression parameters and is not modified by compression.
+// A shrinkler_input can therefore be compressed several times with different parameters,
+// also concurrently from multiple threads, while the suffix array is built only once.
+class shrinkler_input final
+{
+public:
+    // Keeps a copy of the data.
+    explicit shrinkler_input(const std::vector<unsigned char>& data, int threads = 1);
+
+    // Refers to the caller's data, which must outlive the shrinkler_input and must not change.
+    explicit shrinkler_input(std::span<const unsigned char> data, int threads = 1);
+
+    shrinkler_input(const shrinkler_input&) = delete;
+    shrinkler_input& operator=(const shrinkler_input&) = delete;
+    ~shrinkler_input();
+
+    std::span<const unsigned char> data() const { return m_data; }
+
+    const SuffixIndex& index() const { return *m_index; }
+
+private:
+    const std::vector<unsigned char> m_copy;
+    const std::span<const unsigned char> m_data;
+    std::unique_ptr<const SuffixIndex> m_index;
+};
+
+class compression_cancelled final : public std::runtime_error
+{
+public:
+    compression_cancelled() : std::runtime_error("Compression cancelled") {}
+};
+
+enum class log_level
+{
+    verbose,
+    warning
+};
+
+// Receives the messages of a compression, one line at a time and without line terminator.
+// Verbose messages are only produced if shrinkler_parameters::verbose is set.
+using log_sink = std::function<void(log_level level, const std::string& message)>;
+
+// Receives the number of compression passes done and the total number of passes, after each pass.
+// With more than one iteration chain it is called from the chains' threads, but never concurrently.
+// The total is the number of passes without time budget and convergence threshold. Otherwise fewer passes may be done.
+using progress_sink = std::function<void(int passes_done, int passes_total)>;
+
+// Wall time of one phase of a compression:
+// suffix_array, lcp: building the suffix index of the input. Reported by every compression of the input.
+// match_table: finding matches up front.
+// parse, encode, count: parsing, measuring the size of the result with adaptive range coding and counting symbols, once per pass.
+// final_encode, verify: encoding the best result and decoding it again.
+struct compression_phase
+{
+    std::string name;
+    int chain = -1; // Iteration chain, or -1 if the phase is not part of a chain
+    int pass = -1;  // Pass of the chain, or -1 if the phase is not part of a pass
+    std::chrono::steady_clock::time_point begin;
+    std::chrono::steady_clock::time_point end;
+};
+
+// Work done by a compression, summed over all passes and iteration chains.
+struct compression_counters
+{
+    long long matches = 0;           // Matches considered as references
+    long long skipped_positions = 0; // Positions skipped after a match of at least skip_length bytes
+    long long edges_created = 0;     // Reference edges created
+    long long edges_cleaned = 0;     // Reference edges discarded because the buffer was full
+};
+
+class compression_result final
+{
+public:
+    std::vector<unsigned char> data;
+    size_t uncompressed_size = 0;
+    ptrdiff_t safety_margin = 0; // Minimum safety margin for overlapped decrunching
+    int references_considered = 0;
+    int references_discarded = 0;
+    std::vector<double> pass_sizes; // Size in bytes of each pass, of all iteration chains in chain order
+    std::vector<compression_phase> phases; // In order of their beginning
+    compression_counters counters;
+};
+
 class shrinkler_compressor final
 {
 public:
-    std::vector<unsigned char> compress(const std::vector<unsigned char>& data) const;
+    // These print messages to std::cout. The data is not copied.
+    std::vector<unsigned char> compress(std::span<const unsigned char> data) const;
+    std::vector<unsigned char> compress(const shrinkler_input& input) const;
+
+    // Reentrant compression. Messages and progress go to the sinks, which may be empty, but must not throw.
+    // Any number of calls can run at the same time, also on the same compressor and input.
+    compression_result compress(const shrinkler_input& input, const log_sink& log, const progress_sink& progress) const;
+
+    // Like the above, but writes the packed data straight into output, replacing its contents, and leaves result.data empty.
+    // The memory resource of output decides where the packed data goes, e.g. into a caller's buffer.
+    compression_result compress(const shrinkler_input& input, std::pmr::vector<unsigned char>& output, const log_sink& log, const progress_sink& progress) const;
     void set_parameters(const shrinkler_parameters& p) { parameters = p; }
 private:
     shrinkler_parameters parameters;
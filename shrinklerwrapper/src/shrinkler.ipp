@@ -23,6 +23,7 @@
 
 #include "../../3rdparty/Shrinkler/cruncher/HunkFile.h"
 #include "../../3rdparty/Shrinkler/cruncher/Pack.h"
+#include "../../3rdparty/Shrinkler/cruncher/BlockParser.h"
 
 #if defined(__GNUC__) || defined(__clang__)
 #pragma GCC diagnostic pop
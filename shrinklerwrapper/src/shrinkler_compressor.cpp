@@ -2,16 +2,47 @@
 // SPDX-License-Identifier: MIT
 // shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
 
+#include <iostream>
+#include <utility>
 #include "shrinklerwrapper/shrinklerwrapper.hpp"
 #include "shrinkler_compressor_impl.hpp"
 
 namespace shrinklerwrapper
 {
 
-std::vector<unsigned char> shrinkler_compressor::compress(const std::vector<unsigned char>& data) const
+static void print_message(log_level level, const std::string& message)
 {
-    detail::shrinkler_compressor_impl compressor(parameters);
-    return compressor.compress(data);
+    if (level == log_level::warning)
+    {
+        std::cout << "Warning: ";
+    }
+    std::cout << message << std::endl;
+}
+
+std::vector<unsigned char> shrinkler_compressor::compress(std::span<const unsigned char> data) const
+{
+    const shrinkler_input input(data, parameters.threads);
+    return compress(input);
+}
+
+std::vector<unsigned char> shrinkler_compressor::compress(const shrinkler_input& input) const
+{
+    return compress(input, print_message, nullptr).data;
+}
+
+compression_result shrinkler_compressor::compress(const shrinkler_input& input, const log_sink& log, const progress_sink& progress) const
+{
+    std::vector<unsigned char> data;
+    detail::shrinkler_compressor_impl compressor(parameters, log, progress);
+    auto result = compressor.compress(input, [&data](size_t size) { data.resize(size); return data.data(); });
+    result.data = std::move(data);
+    return result;
+}
+
+compression_result shrinkler_compressor::compress(const shrinkler_input& input, std::pmr::vector<unsigned char>& output, const log_sink& log, const progress_sink& progress) const
+{
+    detail::shrinkler_compressor_impl compressor(parameters, log, progress);
+    return compressor.compress(input, [&output](size_t size) { output.resize(size); return output.data(); });
 }
 
 }
@@ -8,17 +8,21 @@
 
 #include "shrinkler.ipp"
 
+#include <algorithm>
 #include <boost/numeric/conversion/cast.hpp>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <format>
-#include <iostream>
+#include <memory>
+#include <sstream>
 #include <stdexcept>
+#include <string>
 #include "shrinkler_compressor_impl.hpp"
 #include "util.hpp"
 
-#define CONSOLE_WARN std::cout << "Warning: "
-#define CONSOLE_VERBOSE if (!parameters.verbose); else std::cout
+#define CONSOLE_WARN log_message(log_output, log_level::warning)
+#define CONSOLE_VERBOSE if (!parameters.verbose); else log_message(log_output, log_level::verbose)
 
 namespace shrinklerwrapper::detail
 {
@@ -26,8 +30,108 @@ namespace shrinklerwrapper::detail
 using boost::numeric_cast;
 using std::endl;
 using std::runtime_error;
+using std::chrono::steady_clock;
 using std::vector;
 
+// Collects a message and passes it to a log sink at the end of the statement.
+// The line terminator of the message is not passed on.
+class log_message final
+{
+public:
+    log_message(const log_sink& sink, log_level level) : m_sink(sink), m_level(level) {}
+
+    ~log_message()
+    {
+        if (m_sink)
+        {
+            auto message = m_stream.str();
+            if (message.ends_with('\n'))
+            {
+                message.pop_back();
+            }
+            m_sink(m_level, message);
+        }
+    }
+
+    template <typename T>
+    log_message& operator<<(const T& value)
+    {
+        m_stream << value;
+        return *this;
+    }
+
+    log_message& operator<<(std::ostream& (*manipulator)(std::ostream&))
+    {
+        m_stream << manipulator;
+        return *this;
+    }
+
+private:
+    const log_sink& m_sink;
+    const log_level m_level;
+    std::ostringstream m_stream;
+};
+
+// Progress of a compression pass. Stops the pass when compression is cancelled, or when the time budget is
+// exhausted and the pass is allowed to time out. Progress is passed on to another progress, if there is one.
+class pass_progress final : public LZProgress
+{
+public:
+    using clock = std::chrono::steady_clock;
+
+    pass_progress(LZProgress* reporter, const std::stop_token& stop_token, clock::time_point deadline)
+        : m_reporter(reporter), m_stop_token(stop_token), m_deadline(deadline) {}
+
+    ~pass_progress()
+    {
+        delete m_reporter;
+    }
+
+    void begin(int size) override
+    {
+        if (m_reporter)
+        {
+            m_reporter->begin(size);
+        }
+    }
+
+    void update(int pos) override
+    {
+        if (m_reporter)
+        {
+            m_reporter->update(pos);
+        }
+    }
+
+    void end() override
+    {
+        if (m_reporter)
+        {
+            m_reporter->end();
+        }
+    }
+
+    bool stopped() override
+    {
+        return cancelled() || (m_may_time_out && (clock::now() >= m_deadline));
+    }
+
+    bool cancelled() const { return m_stop_token.stop_requested(); }
+
+    void may_time_out(bool may_time_out) { m_may_time_out = may_time_out; }
+
+private:
+    LZProgress* const m_reporter;
+    const std::stop_token m_stop_token;
+    const clock::time_point m_deadline;
+    bool m_may_time_out = false;
+};
+
+static compression_phase make_phase(const char* name, steady_clock::time_point begin, int chain = -1, int pass = -1)
+{
+    return { .name = name, .chain = chain, .pass = pass, .begin = begin, .end = steady_clock::now() };
+}
+
 static PackParams create_pack_params(const shrinkler_parameters& parameters)
 {
     return
@@ -42,9 +146,16 @@ static PackParams create_pack_params(const shrinkler_parameters& parameters)
 }
 
 // Corresponds to main in Shrinkler.
-vector<unsigned char> shrinkler_compressor_impl::compress(const vector<unsigned char>& data) const
+compression_result shrinkler_compressor_impl::compress(const shrinkler_input& input, const output_buffer& output)
 {
     CONSOLE_VERBOSE << "Compressing..." << endl;
+    deadline = parameters.time_budget > 0
+        ? steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<double>(parameters.time_budget))
+        : steady_clock::time_point::max();
+
+    const auto& index = input.index();
+    result.phases.push_back({ .name = "suffix_array", .begin = index.build_begin, .end = index.suffix_array_end });
+    result.phases.push_back({ .name = "lcp", .begin = index.suffix_array_end, .end = index.lcp_end });
 
     RefEdgeFactory edge_factory(parameters.references);
     auto pack_params = create_pack_params(parameters);
@@ -54,7 +165,12 @@ vector<unsigned char> shrinkler_compressor_impl::compress(const vector<unsigned
     // On more recent versions of Windows it does, but this needs to be probed for and enabled:
     // https://docs.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences.
     // Not worth the trouble for the time being.
-    auto packed_bytes = crunch(data, pack_params, edge_factory, false);
+    crunch(input, pack_params, edge_factory, false, output);
+    result.uncompressed_size = input.data().size();
+    result.references_considered = edge_factory.max_edge_count;
+    result.references_discarded = edge_factory.max_cleaned_edges;
+    result.counters.edges_created = edge_factory.total_edges;
+    result.counters.edges_cleaned = edge_factory.total_cleaned_edges;
 
     CONSOLE_VERBOSE << std::format("References considered: {}", edge_factory.max_edge_count) << endl;
     CONSOLE_VERBOSE << std::format("References discarded: {}", edge_factory.max_cleaned_edges) << endl;
@@ -64,41 +180,40 @@ vector<unsigned char> shrinkler_compressor_impl::compress(const vector<unsigned
         CONSOLE_WARN << "Compression may benefit from a larger reference buffer (-r option)" << endl;
     }
 
-    return packed_bytes;
+    return std::move(result);
 }
 
 // Corresponds to DataFile::crunch in Shrinkler.
-std::vector<unsigned char> shrinkler_compressor_impl::crunch(const std::vector<unsigned char>& data, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress) const
+void shrinkler_compressor_impl::crunch(const shrinkler_input& input, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress, const output_buffer& output)
 {
-    // Shrinkler code uses non-const buffers all over the place, so we create a copy of the original data.
-    vector<unsigned char> non_const_data = data;
-
     // Compress and verify
-    vector<uint32_t> pack_buffer = compress(non_const_data, params, edge_factory, show_progress);
-    auto margin = verify(non_const_data, pack_buffer, params);
-    CONSOLE_VERBOSE << "Minimum safety margin for overlapped decrunching: " << margin << endl;
+    vector<uint32_t> pack_buffer = compress(input.data(), input.index(), params, edge_factory, show_progress);
+    const auto verify_begin = steady_clock::now();
+    result.safety_margin = verify(input.data(), pack_buffer, params);
+    result.phases.push_back(make_phase("verify", verify_begin));
+    CONSOLE_VERBOSE << "Minimum safety margin for overlapped decrunching: " << result.safety_margin << endl;
 
     // Shrinkler produces packed data suitable for 68k CPUs.
     // For the GBA's ARM7TDMI convert the data to little endian.
-    return to_little_endian(pack_buffer);
+    to_little_endian(pack_buffer, output(pack_buffer.size() * sizeof(pack_buffer[0])));
 }
 
 // Corresponds to DataFile::compress in Shrinkler.
-std::vector<uint32_t> shrinkler_compressor_impl::compress(std::vector<unsigned char>& data, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress) const
+std::vector<uint32_t> shrinkler_compressor_impl::compress(std::span<const unsigned char> data, const SuffixIndex& index, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress)
 {
     vector<uint32_t> pack_buffer;
     RangeCoder range_coder(LZEncoder::NUM_CONTEXTS + NUM_RELOC_CONTEXTS, pack_buffer);
 
     // Crunch the data
     range_coder.reset();
-    packData(&data[0], numeric_cast<int>(data.size()), 0, &params, &range_coder, &edge_factory, show_progress);
+    packData(data.data(), numeric_cast<int>(data.size()), 0, index, &params, &range_coder, &edge_factory, show_progress);
     range_coder.finish();
 
     return pack_buffer;
 }
 
 // Corresponds to DataFile::verify in Shrinkler.
-ptrdiff_t shrinkler_compressor_impl::verify(std::vector<unsigned char>& data, std::vector<uint32_t>& pack_buffer, PackParams& params) const
+ptrdiff_t shrinkler_compressor_impl::verify(std::span<const unsigned char> data, std::vector<uint32_t>& pack_buffer, PackParams& params)
 {
     CONSOLE_VERBOSE << "Verifying..." << endl;
 
@@ -106,7 +221,7 @@ ptrdiff_t shrinkler_compressor_impl::verify(std::vector<unsigned char>& data, st
     LZDecoder lzd(&decoder, params.parity_context);
 
     // Verify data
-    LZVerifier verifier(0, &data[0], numeric_cast<int>(data.size()), numeric_cast<int>(data.size()));
+    LZVerifier verifier(0, data.data(), numeric_cast<int>(data.size()), numeric_cast<int>(data.size()));
     decoder.reset();
     decoder.setListener(&verifier);
     if (!lzd.decode(verifier))
@@ -123,62 +238,269 @@ ptrdiff_t shrinkler_compressor_impl::verify(std::vector<unsigned char>& data, st
     return verifier.front_overlap_margin + pack_buffer.size() * 4 - data.size();
 }
 
-void shrinkler_compressor_impl::packData(unsigned char* data, int data_length, int zero_padding, PackParams* params, Coder* result_coder, RefEdgeFactory* edge_factory, bool show_progress) const
+void shrinkler_compressor_impl::packData(const unsigned char* data, int data_length, int zero_padding, const SuffixIndex& index, PackParams* params, Coder* result_coder, RefEdgeFactory* edge_factory, bool show_progress)
+{
+    if (params->parity_context)
+    {
+        packDataSpecialized<true>(data, data_length, zero_padding, index, params, result_coder, edge_factory, show_progress);
+    }
+    else
+    {
+        packDataSpecialized<false>(data, data_length, zero_padding, index, params, result_coder, edge_factory, show_progress);
+    }
+}
+
+// Bias the initial model of an iteration chain towards literals (odd chains) or references (even chains),
+// more strongly for higher chain numbers. Chain 0 starts from the uniform model, like a single chain does.
+static void seed_chain_model(CountingCoder& counting_coder, int chain, int data_length)
+{
+    if (chain == 0)
+    {
+        return;
+    }
+
+    const int strength = (chain + 1) / 2;
+    const int favored = data_length / 8;
+    const int other = favored >> std::min(2 * strength, 30);
+    const bool literal_heavy = (chain & 1) != 0;
+    for (int parity = 0; parity < 2; parity++)
+    {
+        counting_coder.addCounts(LZEncoder::kindContextIndex(parity), literal_heavy ? favored : other, literal_heavy ? other : favored);
+    }
+}
+
+// Uses LZ encoders specialized for each coder type and the parity setting,
+// so that the coders' functions can be inlined.
+template <bool parity_context>
+void shrinkler_compressor_impl::packDataSpecialized(const unsigned char* data, int data_length, int zero_padding, const SuffixIndex& index, PackParams* params, Coder* result_coder, RefEdgeFactory* edge_factory, bool show_progress)
 {
-    MatchFinder finder(data, data_length, 2, params->match_patience, params->max_same_length);
-    LZParser parser(data, data_length, zero_padding, finder, params->length_margin, params->skip_length, edge_factory);
-    result_size_t real_size = 0;
-    result_size_t best_size = (result_size_t)1 << (32 + 3 + Coder::BIT_PRECISION);
-    int best_result = 0;
-    vector<LZParseResult> results(2);
-    CountingCoder* counting_coder = new CountingCoder(LZEncoder::NUM_CONTEXTS);
-    LZProgress* progress;
-    if (show_progress) {
-        progress = new PackProgress();
-    }
-    else {
-        progress = new NoProgress();
+    // With more than one iteration, find matches once up front instead of in every iteration.
+    std::unique_ptr<MatchTable> match_table;
+    if (parameters.precompute_matches && (params->iterations > 1))
+    {
+        const auto match_table_begin = steady_clock::now();
+        pass_progress progress(nullptr, parameters.stop_token, deadline);
+        progress.may_time_out(true);
+        match_table = std::make_unique<MatchTable>(index, 2, params->match_patience, params->max_same_length, parameters.range_index, params->skip_length, parameters.threads,
+            [&progress]() { return progress.stopped(); });
+        result.phases.push_back(make_phase("match_table", match_table_begin));
+        if (match_table->interrupted)
+        {
+            // The first pass finds matches itself then. It stops right away if compression was cancelled.
+            match_table.reset();
+        }
+    }
+
+    // Independent iteration chains run in parallel, each starting from a different initial model.
+    // Chains and block parsing share the thread budget: at most one thread per chain runs chains,
+    // and the remaining threads are divided among the chains for block parsing.
+    const int chains = std::max(1, parameters.chains);
+    const int chain_threads = std::clamp(parameters.threads, 1, chains);
+    const int threads_per_chain = std::max(1, parameters.threads / chain_threads);
+    if (parameters.parse_block_size > 0)
+    {
+        CONSOLE_VERBOSE << std::format("Parsing in blocks of {} bytes using {} threads", parameters.parse_block_size, threads_per_chain) << endl;
+    }
+    if (chains > 1)
+    {
+        CONSOLE_VERBOSE << std::format("Running {} iteration chains using {} threads", chains, chain_threads) << endl;
     }
+
+    vector<LZParseResult> chain_results(chains);
+    vector<result_size_t> chain_sizes(chains);
+    vector<vector<result_size_t>> pass_sizes(chains);
+    vector<std::unique_ptr<RefEdgeFactory>> chain_edge_factories(chains);
+    vector<std::string> stop_reasons(chains);
+    vector<vector<compression_phase>> chain_phases(chains);
+    vector<LZParseCounts> chain_counts(chains);
+
+    auto run_chain = [&](int chain)
+    {
+        RefEdgeFactory* chain_edge_factory = edge_factory;
+        if (chain > 0)
+        {
+            chain_edge_factories[chain] = std::make_unique<RefEdgeFactory>(parameters.references);
+            chain_edge_factory = chain_edge_factories[chain].get();
+        }
+
+        MatchFinder finder(index, 2, params->match_patience, params->max_same_length, parameters.range_index);
+        LZParser parser(data, data_length, zero_padding, finder, params->length_margin, params->skip_length, chain_edge_factory, match_table.get());
+
+        // Optionally parse blocks of the data in parallel, at the expense of a slightly worse compression ratio.
+        std::unique_ptr<BlockParser> block_parser;
+        if (parameters.parse_block_size > 0)
+        {
+            block_parser = std::make_unique<BlockParser>(data, data_length, zero_padding, index, params->match_patience, params->max_same_length, parameters.range_index, params->length_margin, params->skip_length, parameters.references, match_table.get(), parameters.parse_block_size, threads_per_chain);
+        }
+
+        result_size_t real_size = 0;
+        result_size_t best_size = (result_size_t)1 << (32 + 3 + Coder::BIT_PRECISION);
+        int best_result = 0;
+        vector<LZParseResult> results(2);
+        CountingCoder* counting_coder = new CountingCoder(LZEncoder::NUM_CONTEXTS);
+        seed_chain_model(*counting_coder, chain, data_length);
+        pass_progress* progress = new pass_progress(show_progress && (chains == 1) ? new PackProgress() : nullptr, parameters.stop_token, deadline);
+        for (int i = 0; i < params->iterations; i++) {
+            // Only passes after the first may time out, so that there is always a complete result.
+            progress->may_time_out(i > 0);
+            if (progress->stopped()) {
+                stop_reasons[chain] = progress->cancelled() ? "cancelled" : std::format("time budget exhausted after pass {}", i);
+                break;
+            }
+
+            // Parse data into LZ symbols
+            LZParseResult& result = results[1 - best_result];
+            SizeMeasuringCoder* measurer = new SizeMeasuringCoder(counting_coder);
+            measurer->setNumberContexts(LZEncoder::NUMBER_CONTEXT_OFFSET, LZEncoder::NUM_NUMBER_CONTEXTS, data_length);
+            finder.reset();
+            MeasuringLZEncoder<parity_context> measuring_encoder(measurer);
+            auto phase_begin = steady_clock::now();
+            result = block_parser ? block_parser->parse(measuring_encoder, progress) : parser.parse(measuring_encoder, progress);
+            chain_phases[chain].push_back(make_phase("parse", phase_begin, chain, i));
+            delete measurer;
+            if (result.interrupted) {
+                // The result of the pass is incomplete, but the best result so far is in the other slot.
+                stop_reasons[chain] = progress->cancelled() ? "cancelled" : std::format("time budget exhausted during pass {}", i + 1);
+                break;
+            }
+
+            // Encode result using adaptive range coding
+            phase_begin = steady_clock::now();
+            RangeCoder* range_coder = new RangeCoder(LZEncoder::NUM_CONTEXTS);
+            real_size = result.encode(SpecializedLZEncoder<RangeCoder, parity_context>(range_coder));
+            range_coder->finish();
+            delete range_coder;
+            chain_phases[chain].push_back(make_phase("encode", phase_begin, chain, i));
+
+            // Choose if best
+            if (real_size < best_size) {
+                best_result = 1 - best_result;
+                best_size = real_size;
+            }
+
+            // Remember size for printing
+            pass_sizes[chain].push_back(real_size);
+            report_progress(chains * params->iterations);
+
+            // Count symbol frequencies
+            phase_begin = steady_clock::now();
+            CountingCoder* new_counting_coder = new CountingCoder(LZEncoder::NUM_CONTEXTS);
+            result.encode(SpecializedLZEncoder<CountingCoder, parity_context>(counting_coder));
+
+            // New size measurer based on frequencies
+            CountingCoder* old_counting_coder = counting_coder;
+            counting_coder = new CountingCoder(old_counting_coder, new_counting_coder);
+            delete old_counting_coder;
+            delete new_counting_coder;
+            chain_phases[chain].push_back(make_phase("count", phase_begin, chain, i));
+
+            // Stop if the pass did not gain enough
+            if (parameters.convergence_threshold > 0 && i > 0) {
+                const double gain = ((double)pass_sizes[chain][i - 1] - (double)real_size) / (8 << Coder::BIT_PRECISION);
+                if (gain < parameters.convergence_threshold) {
+                    stop_reasons[chain] = std::format("converged, pass {} gained {:.3f} bytes", i + 1, gain);
+                    break;
+                }
+            }
+        }
+        delete progress;
+        delete counting_coder;
+
+        chain_counts[chain] = parser.counts;
+        if (block_parser)
+        {
+            block_parser->mergeStatistics(chain_edge_factory);
+            chain_counts[chain].add(block_parser->counts());
+        }
+
+        chain_results[chain] = std::move(results[best_result]);
+        chain_sizes[chain] = best_size;
+    };
+
     CONSOLE_VERBOSE << "Original: " << data_length << endl;
-    for (int i = 0; i < params->iterations; i++) {
-        // Parse data into LZ symbols
-        LZParseResult& result = results[1 - best_result];
-        Coder* measurer = new SizeMeasuringCoder(counting_coder);
-        measurer->setNumberContexts(LZEncoder::NUMBER_CONTEXT_OFFSET, LZEncoder::NUM_NUMBER_CONTEXTS, data_length);
-        finder.reset();
-        result = parser.parse(LZEncoder(measurer, params->parity_context), progress);
-        delete measurer;
-
-        // Encode result using adaptive range coding
-        vector<unsigned> dummy_result;
-        RangeCoder* range_coder = new RangeCoder(LZEncoder::NUM_CONTEXTS, dummy_result);
-        real_size = result.encode(LZEncoder(range_coder, params->parity_context));
-        range_coder->finish();
-        delete range_coder;
-
-        // Choose if best
-        if (real_size < best_size) {
-            best_result = 1 - best_result;
-            best_size = real_size;
+    parallelFor(chain_threads, chains, [&](int, int begin, int end)
+    {
+        for (int chain = begin; chain < end; chain++)
+        {
+            run_chain(chain);
         }
+    });
+    if (parameters.stop_token.stop_requested())
+    {
+        throw compression_cancelled();
+    }
 
-        // Print size
-        CONSOLE_VERBOSE << std::format("Pass {}: {:.3f}", i + 1, real_size / (double)(8 << Coder::BIT_PRECISION)) << endl;
+    // Keep the smallest result. On a tie, prefer the lower chain number, so the result does not depend on thread timing.
+    int best_chain = 0;
+    for (int chain = 0; chain < chains; chain++)
+    {
+        for (size_t i = 0; i < pass_sizes[chain].size(); i++)
+        {
+            const auto pass_size = pass_sizes[chain][i] / (double)(8 << Coder::BIT_PRECISION);
+            result.pass_sizes.push_back(pass_size);
+            CONSOLE_VERBOSE << (chains > 1 ? std::format("Chain {} pass {}: {:.3f}", chain + 1, i + 1, pass_size) : std::format("Pass {}: {:.3f}", i + 1, pass_size)) << endl;
+        }
+        if (!stop_reasons[chain].empty())
+        {
+            CONSOLE_VERBOSE << (chains > 1 ? std::format("Chain {} stopped early: {}", chain + 1, stop_reasons[chain]) : std::format("Stopped early: {}", stop_reasons[chain])) << endl;
+        }
+        if (chain_sizes[chain] < chain_sizes[best_chain])
+        {
+            best_chain = chain;
+        }
+        if (chain_edge_factories[chain])
+        {
+            edge_factory->mergeStatistics(*chain_edge_factories[chain]);
+        }
+        result.counters.matches += chain_counts[chain].matches;
+        result.counters.skipped_positions += chain_counts[chain].skipped_positions;
+    }
 
-        // Count symbol frequencies
-        CountingCoder* new_counting_coder = new CountingCoder(LZEncoder::NUM_CONTEXTS);
-        result.encode(LZEncoder(counting_coder, params->parity_context));
+    // Chains run at the same time, so order their phases by beginning.
+    vector<compression_phase> phases;
+    for (auto& p : chain_phases)
+    {
+        phases.insert(phases.end(), p.begin(), p.end());
+    }
+    std::stable_sort(phases.begin(), phases.end(), [](const compression_phase& a, const compression_phase& b) { return a.begin < b.begin; });
+    result.phases.insert(result.phases.end(), phases.begin(), phases.end());
+    if (chains > 1)
+    {
+        CONSOLE_VERBOSE << std::format("Keeping result of chain {}", best_chain + 1) << endl;
+    }
 
-        // New size measurer based on frequencies
-        CountingCoder* old_counting_coder = counting_coder;
-        counting_coder = new CountingCoder(old_counting_coder, new_counting_coder);
-        delete old_counting_coder;
-        delete new_counting_coder;
+    const auto final_encode_begin = steady_clock::now();
+    chain_results[best_chain].encode(SpecializedLZEncoder<Coder, parity_context>(result_coder));
+    result.phases.push_back(make_phase("final_encode", final_encode_begin));
+}
+
+void shrinkler_compressor_impl::report_progress(int passes_total)
+{
+    std::scoped_lock lock(progress_mutex);
+    ++passes_done;
+    if (progress_output)
+    {
+        progress_output(passes_done, passes_total);
     }
-    delete progress;
-    delete counting_coder;
+}
 
-    results[best_result].encode(LZEncoder(result_coder, params->parity_context));
 }
 
+namespace shrinklerwrapper
+{
+
+// The Shrinkler code can only be included once, so shrinkler_input is implemented here too.
+shrinkler_input::shrinkler_input(const std::vector<unsigned char>& data, int threads)
+    : m_copy(data),
+      m_data(m_copy),
+      m_index(std::make_unique<SuffixIndex>(m_data.data(), boost::numeric_cast<int>(m_data.size()), threads))
+{}
+
+shrinkler_input::shrinkler_input(std::span<const unsigned char> data, int threads)
+    : m_data(data),
+      m_index(std::make_unique<SuffixIndex>(m_data.data(), boost::numeric_cast<int>(m_data.size()), threads))
+{}
+
+shrinkler_input::~shrinkler_input() = default;
+
 }
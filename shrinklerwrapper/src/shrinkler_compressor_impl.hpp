@@ -5,12 +5,18 @@
 #ifndef SHRINKLERWRAPPER_SHRINKLER_COMPRESSOR_IMPL_HPP
 #define SHRINKLERWRAPPER_SHRINKLER_COMPRESSOR_IMPL_HPP
 
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <span>
 #include <vector>
 #include "shrinklerwrapper/shrinklerwrapper.hpp"
 
 class Coder;
 struct PackParams;
 class RefEdgeFactory;
+class SuffixIndex;
 
 namespace shrinklerwrapper::detail
 {
@@ -18,19 +24,37 @@ namespace shrinklerwrapper::detail
 class shrinkler_compressor_impl final
 {
 public:
-    shrinkler_compressor_impl(const shrinkler_parameters& parameters) : parameters(parameters) {}
+    // An instance compresses one input. All state of the compression lives in the instance.
+    shrinkler_compressor_impl(const shrinkler_parameters& parameters, const log_sink& log_output, const progress_sink& progress_output)
+        : parameters(parameters), log_output(log_output), progress_output(progress_output) {}
 
-    std::vector<unsigned char> compress(const std::vector<unsigned char>& data) const;
+    // Returns a buffer of the given size for the packed data.
+    using output_buffer = std::function<unsigned char*(size_t size)>;
+
+    // The packed data goes to the buffer returned by output, so the data of the result is empty.
+    compression_result compress(const shrinkler_input& input, const output_buffer& output);
 private:
-    std::vector<unsigned char> crunch(const std::vector<unsigned char>& data, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress) const;
-    std::vector<uint32_t> compress(std::vector<unsigned char>& data, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress) const;
+    void crunch(const shrinkler_input& input, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress, const output_buffer& output);
+    std::vector<uint32_t> compress(std::span<const unsigned char> data, const SuffixIndex& index, PackParams& params, RefEdgeFactory& edge_factory, bool show_progress);
 
     static_assert(sizeof(ptrdiff_t) >= sizeof(size_t));
-    ptrdiff_t verify(std::vector<unsigned char>& data, std::vector<uint32_t>& pack_buffer, PackParams& params) const;
+    ptrdiff_t verify(std::span<const unsigned char> data, std::vector<uint32_t>& pack_buffer, PackParams& params);
+
+    void packData(const unsigned char* data, int data_length, int zero_padding, const SuffixIndex& index, PackParams* params, Coder* result_coder, RefEdgeFactory* edge_factory, bool show_progress);
+    template <bool parity_context>
+    void packDataSpecialized(const unsigned char* data, int data_length, int zero_padding, const SuffixIndex& index, PackParams* params, Coder* result_coder, RefEdgeFactory* edge_factory, bool show_progress);
 
-    void packData(unsigned char* data, int data_length, int zero_padding, PackParams* params, Coder* result_coder, RefEdgeFactory* edge_factory, bool show_progress) const;
+    void report_progress(int passes_total);
 
     shrinkler_parameters parameters;
+    const log_sink& log_output;
+    const progress_sink& progress_output;
+    compression_result result;
+    // The time budget counts from the start of compress. Building the suffix index of the input is not included,
+    // since an input can be compressed several times.
+    std::chrono::steady_clock::time_point deadline;
+    std::mutex progress_mutex;
+    int passes_done = 0;
 };
 
 }
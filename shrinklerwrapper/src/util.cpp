@@ -7,20 +7,15 @@
 namespace shrinklerwrapper::detail
 {
 
-std::vector<unsigned char> to_little_endian(const std::vector<uint32_t>& buffer)
+void to_little_endian(std::span<const uint32_t> buffer, unsigned char* out)
 {
-    std::vector<unsigned char> packed_bytes;
-    packed_bytes.reserve(buffer.size() * sizeof(buffer[0]));
-
     for (auto word : buffer)
     {
-        packed_bytes.push_back(word & 0xff);
-        packed_bytes.push_back((word >> 8) & 0xff);
-        packed_bytes.push_back((word >> 16) & 0xff);
-        packed_bytes.push_back((word >> 24) & 0xff);
+        *out++ = word & 0xff;
+        *out++ = (word >> 8) & 0xff;
+        *out++ = (word >> 16) & 0xff;
+        *out++ = (word >> 24) & 0xff;
     }
-
-    return packed_bytes;
 }
 
 }
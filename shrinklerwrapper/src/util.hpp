@@ -6,12 +6,13 @@
 #define SHRINKLERWRAPPER_UTIL_HPP
 
 #include <cstdint>
-#include <vector>
+#include <span>
 
 namespace shrinklerwrapper::detail
 {
 
-std::vector<unsigned char> to_little_endian(const std::vector<uint32_t>& buffer);
+// Writes the words to out as little endian bytes. out must have room for four bytes per word.
+void to_little_endian(std::span<const uint32_t> buffer, unsigned char* out);
 
 }
 
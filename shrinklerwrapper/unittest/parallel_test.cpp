@@ -0,0 +1,66 @@
+// SPDX-FileCopyrightText: 2026 Thomas Mathys
+// SPDX-License-Identifier: MIT
+// shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
+
+#include <atomic>
+#include <boost/test/unit_test.hpp>
+#include <stdexcept>
+#include <vector>
+#include "../../3rdparty/Shrinkler/cruncher/Parallel.h"
+
+namespace shrinklerwrapper_unittest
+{
+
+BOOST_AUTO_TEST_SUITE(parallel_test)
+
+    BOOST_AUTO_TEST_CASE(parallel_for_covers_range)
+    {
+        std::vector<int> visits(1000);
+
+        parallelFor(4, static_cast<int>(visits.size()), [&](int, int begin, int end)
+        {
+            for (int i = begin; i < end; ++i)
+            {
+                ++visits[i];
+            }
+        });
+
+        BOOST_TEST(visits == std::vector<int>(1000, 1), boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(parallel_for_rethrows_exception_of_spawned_thread)
+    {
+        std::atomic<int> done = 0;
+
+        BOOST_CHECK_THROW(parallelFor(4, 4, [&](int t, int, int)
+        {
+            if (t == 2)
+            {
+                throw std::runtime_error("thread 2");
+            }
+            ++done;
+        }), std::runtime_error);
+
+        // All other threads ran to completion before the exception was rethrown.
+        BOOST_TEST(done == 3);
+    }
+
+    BOOST_AUTO_TEST_CASE(parallel_for_rethrows_exception_of_calling_thread)
+    {
+        std::atomic<int> done = 0;
+
+        BOOST_CHECK_THROW(parallelFor(4, 4, [&](int t, int, int)
+        {
+            if (t == 0)
+            {
+                throw std::bad_alloc();
+            }
+            ++done;
+        }), std::bad_alloc);
+
+        BOOST_TEST(done == 3);
+    }
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}
@@ -2,7 +2,16 @@
 // SPDX-License-Identifier: MIT
 // shrinkler-gba: Port of the Shrinkler Amiga executable cruncher for the GBA
 
+#include <algorithm>
+#include <atomic>
 #include <boost/test/unit_test.hpp>
+#include <format>
+#include <memory_resource>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
 #include "shrinklerwrapper/shrinklerwrapper.hpp"
 
 namespace shrinklerwrapper_unittest
@@ -15,6 +24,30 @@ static std::vector<unsigned char> make_vector(const char* s)
     return std::vector<unsigned char>(s, s + strlen(s));
 }
 
+namespace
+{
+
+// Pseudo random words and bytes, compressible enough to produce plenty of matches.
+// Returns at least size bytes. After a random number of words a run of zero_run_length zeros is inserted.
+std::vector<unsigned char> make_test_data(size_t size, uint32_t seed, size_t zero_run_length = 0)
+{
+    std::vector<unsigned char> data;
+    while (data.size() < size)
+    {
+        seed = seed * 1103515245 + 12345;
+        auto s = make_vector((seed >> 16) & 1 ? "foo" : "bar baz ");
+        data.insert(data.end(), s.begin(), s.end());
+        data.push_back((seed >> 8) & 0xff);
+        if (zero_run_length && ((seed >> 24) == 0))
+        {
+            data.insert(data.end(), zero_run_length, 0);
+        }
+    }
+    return data;
+}
+
+}
+
 BOOST_AUTO_TEST_SUITE(shrinkler_compressor_test)
 
     BOOST_AUTO_TEST_CASE(compress)
@@ -43,6 +76,333 @@ BOOST_AUTO_TEST_SUITE(shrinkler_compressor_test)
         BOOST_TEST(expected == compressed, boost::test_tools::per_element());
     }
 
+    BOOST_AUTO_TEST_CASE(compress_multithreaded)
+    {
+        // Input must be large enough for the multithreaded code paths to kick in.
+        auto original = make_test_data(100000, 1);
+        shrinkler_parameters parameters(1);
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(original);
+
+        parameters.threads = 4;
+        testee.set_parameters(parameters);
+        auto compressed = testee.compress(original);
+
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_precomputed_matches)
+    {
+        // Zero runs longer than the skip length make the parser skip positions.
+        auto original = make_test_data(20000, 1, 5000);
+        shrinkler_parameters parameters(3);
+        parameters.precompute_matches = false;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(original);
+
+        parameters.precompute_matches = true;
+        parameters.threads = 3;
+        testee.set_parameters(parameters);
+        auto compressed = testee.compress(original);
+
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_range_index)
+    {
+        // With an effort larger than the input the match finder never gives up,
+        // which is what it does when it uses the range index.
+        auto original = make_test_data(20000, 1);
+        shrinkler_parameters parameters(2);
+        parameters.effort = 100000;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(original);
+
+        parameters.effort = 0;
+        parameters.range_index = true;
+        testee.set_parameters(parameters);
+        auto compressed = testee.compress(original);
+
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_range_index_parallel)
+    {
+        // Each thread building the match table starts in the middle of the data,
+        // so its match finder builds the position index from the suffix array.
+        auto original = make_test_data(20000, 1);
+        shrinkler_parameters parameters(2);
+        parameters.range_index = true;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(original);
+
+        parameters.threads = 3;
+        testee.set_parameters(parameters);
+        auto compressed = testee.compress(original);
+
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_blocks)
+    {
+        // Blocks must be small enough for the input to have several seams.
+        // The compressed data is verified by the compressor.
+        auto original = make_test_data(50000, 1);
+        shrinkler_parameters parameters(2);
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto unsplit = testee.compress(original);
+
+        parameters.parse_block_size = 4000;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(original);
+
+        parameters.threads = 3;
+        testee.set_parameters(parameters);
+        auto compressed = testee.compress(original);
+
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+        BOOST_TEST(compressed.size() < unsplit.size() * 21 / 20);
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_chains)
+    {
+        // The first chain starts from the same model as a single chain, so more chains never compress worse.
+        auto original = make_test_data(20000, 1);
+        shrinkler_parameters parameters(3);
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto single = testee.compress(original);
+
+        parameters.chains = 4;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(original);
+
+        parameters.threads = 4;
+        testee.set_parameters(parameters);
+        auto compressed = testee.compress(original);
+
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+        BOOST_TEST(compressed.size() <= single.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_single_block)
+    {
+        auto original = make_vector("foo foo foo foo");
+        shrinkler_parameters parameters(9);
+        parameters.parse_block_size = 1000;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+
+        auto compressed = testee.compress(original);
+
+        unsigned char expected[]{ 0xc6, 0x62, 0xc8, 0x99, 0x00, 0x00, 0x39, 0x9b };
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_into_caller_buffer)
+    {
+        auto original = make_vector("foo foo foo foo");
+        shrinkler_compressor testee;
+        testee.set_parameters(shrinkler_parameters(9));
+        const shrinkler_input input(std::span(original.data(), original.size()));
+        unsigned char buffer[64];
+        std::pmr::monotonic_buffer_resource memory(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+        std::pmr::vector<unsigned char> compressed(&memory);
+
+        auto result = testee.compress(input, compressed, nullptr, nullptr);
+
+        unsigned char expected[]{ 0xc6, 0x62, 0xc8, 0x99, 0x00, 0x00, 0x39, 0x9b };
+        BOOST_TEST(expected == compressed, boost::test_tools::per_element());
+        BOOST_TEST(compressed.data() >= buffer);
+        BOOST_TEST(compressed.data() < buffer + sizeof(buffer));
+        BOOST_TEST(input.data().data() == original.data());
+        BOOST_TEST(result.data.empty());
+        BOOST_TEST(result.uncompressed_size == original.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_convergence_threshold)
+    {
+        // Every pass after the first gains less than the threshold, so compression stops after the second pass.
+        auto original = make_test_data(20000, 1);
+        const shrinkler_input input(original);
+        shrinkler_parameters parameters(9);
+        parameters.iterations = 2;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(input);
+
+        parameters.iterations = 9;
+        parameters.convergence_threshold = 1000000;
+        testee.set_parameters(parameters);
+        auto result = testee.compress(input, nullptr, nullptr);
+
+        BOOST_TEST(result.pass_sizes.size() == 2u);
+        BOOST_TEST(result.data == expected, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_time_budget)
+    {
+        // The budget is exhausted right away, but the first pass of each chain always completes.
+        auto original = make_test_data(20000, 1);
+        const shrinkler_input input(original);
+        shrinkler_parameters parameters(3);
+        parameters.iterations = 1;
+        parameters.parse_block_size = 4000;
+        parameters.chains = 2;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        auto expected = testee.compress(input);
+
+        parameters.iterations = 3;
+        parameters.time_budget = 1e-9;
+        testee.set_parameters(parameters);
+        auto result = testee.compress(input, nullptr, nullptr);
+
+        BOOST_TEST(result.pass_sizes.size() == 2u);
+        BOOST_TEST(result.data == expected, boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_cancelled)
+    {
+        auto original = make_vector("foo foo foo foo");
+        const shrinkler_input input(original);
+        std::stop_source stop_source;
+        shrinkler_parameters parameters(3);
+        parameters.stop_token = stop_source.get_token();
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        int passes = 0;
+
+        // Cancel from the progress sink, like a user interface would from another thread.
+        BOOST_CHECK_THROW(testee.compress(input, nullptr, [&](int passes_done, int) { passes = passes_done; stop_source.request_stop(); }), compression_cancelled);
+        BOOST_TEST(passes == 1);
+        BOOST_CHECK_THROW(testee.compress(input, nullptr, nullptr), compression_cancelled);
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_with_sinks)
+    {
+        auto original = make_vector("foo foo foo foo");
+        shrinkler_parameters parameters(3);
+        parameters.verbose = true;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+        const shrinkler_input input(original);
+        std::vector<std::string> messages;
+        std::vector<int> progress;
+
+        auto result = testee.compress(
+            input,
+            [&](log_level level, const std::string& message) { if (level == log_level::verbose) messages.push_back(message); },
+            [&](int passes_done, int passes_total) { BOOST_TEST(passes_total == 3); progress.push_back(passes_done); });
+
+        BOOST_TEST(result.data == testee.compress(input, nullptr, nullptr).data, boost::test_tools::per_element());
+        BOOST_TEST(result.uncompressed_size == original.size());
+        BOOST_TEST(result.pass_sizes.size() == 3u);
+        BOOST_TEST(result.references_considered > 0);
+        BOOST_TEST(messages.front() == "Compressing...");
+        BOOST_TEST(messages.back() == std::format("References discarded: {}", result.references_discarded));
+        BOOST_TEST(progress == std::vector<int>({ 1, 2, 3 }), boost::test_tools::per_element());
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_reports_phases_and_counters)
+    {
+        auto original = make_vector("foo foo foo foo");
+        shrinkler_parameters parameters(3);
+        parameters.chains = 2;
+        shrinkler_compressor testee;
+        testee.set_parameters(parameters);
+
+        auto result = testee.compress(shrinkler_input(original), nullptr, nullptr);
+
+        std::vector<std::string> names;
+        for (const auto& phase : result.phases)
+        {
+            BOOST_TEST((phase.begin <= phase.end));
+            if (phase.name == "parse")
+            {
+                BOOST_TEST(phase.chain >= 0);
+                BOOST_TEST(phase.chain < 2);
+                BOOST_TEST(phase.pass >= 0);
+                BOOST_TEST(phase.pass < 3);
+            }
+            if (std::find(names.begin(), names.end(), phase.name) == names.end())
+            {
+                names.push_back(phase.name);
+            }
+        }
+        BOOST_TEST(std::count_if(result.phases.begin(), result.phases.end(), [](const auto& p) { return p.name == "parse"; }) == 6);
+        BOOST_TEST(names == std::vector<std::string>({ "suffix_array", "lcp", "match_table", "parse", "encode", "count", "final_encode", "verify" }), boost::test_tools::per_element());
+        BOOST_TEST(result.counters.matches > 0);
+        BOOST_TEST(result.counters.edges_created > 0);
+        BOOST_TEST(result.counters.edges_cleaned <= result.counters.edges_created);
+    }
+
+    BOOST_AUTO_TEST_CASE(compress_concurrently)
+    {
+        // Compress different inputs with different parameters on many threads at once.
+        // Every result must be the same as when compressed alone. Most useful when built with -fsanitize=thread.
+        constexpr int nthreads = 8;
+        const std::vector<std::vector<unsigned char>> originals{ make_test_data(5000, 1), make_test_data(20000, 2) };
+        std::vector<shrinkler_parameters> parameters(nthreads, shrinkler_parameters(2));
+        for (int i = 0; i < nthreads; i++)
+        {
+            parameters[i].verbose = true;
+            parameters[i].chains = 1 + i % 3;
+            parameters[i].threads = 1 + i % 2;
+            parameters[i].parse_block_size = i % 4 == 3 ? 2000 : 0;
+        }
+        const shrinkler_input small_input(originals[0], 2);
+        const shrinkler_input large_input(originals[1], 2);
+        const shrinkler_input* inputs[]{ &small_input, &large_input };
+
+        std::vector<std::vector<unsigned char>> expected(nthreads);
+        for (int i = 0; i < nthreads; i++)
+        {
+            shrinkler_compressor compressor;
+            compressor.set_parameters(parameters[i]);
+            expected[i] = compressor.compress(*inputs[i % 2], nullptr, nullptr).data;
+        }
+
+        std::vector<compression_result> results(nthreads);
+        std::vector<int> message_counts(nthreads);
+        std::vector<int> progress_counts(nthreads);
+        std::atomic<int> ready = 0;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < nthreads; i++)
+        {
+            threads.emplace_back([&, i]()
+            {
+                shrinkler_compressor compressor;
+                compressor.set_parameters(parameters[i]);
+                ++ready;
+                while (ready < nthreads)
+                {
+                    std::this_thread::yield();
+                }
+                results[i] = compressor.compress(
+                    *inputs[i % 2],
+                    [&, i](log_level, const std::string&) { ++message_counts[i]; },
+                    [&, i](int, int) { ++progress_counts[i]; });
+            });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        for (int i = 0; i < nthreads; i++)
+        {
+            BOOST_TEST(results[i].data == expected[i], boost::test_tools::per_element());
+            BOOST_TEST(message_counts[i] > 0);
+            BOOST_TEST(progress_counts[i] == parameters[i].chains * parameters[i].iterations);
+        }
+    }
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }
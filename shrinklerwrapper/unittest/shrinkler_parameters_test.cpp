@@ -23,6 +23,13 @@ BOOST_AUTO_TEST_SUITE(shrinkler_parameters_test)
         BOOST_TEST(testee.effort == 200);
         BOOST_TEST(testee.skip_length == 2000);
         BOOST_TEST(testee.references == 100000);
+        BOOST_TEST(testee.threads == 1);
+        BOOST_TEST(testee.precompute_matches == true);
+        BOOST_TEST(testee.range_index == false);
+        BOOST_TEST(testee.parse_block_size == 0);
+        BOOST_TEST(testee.chains == 1);
+        BOOST_TEST(testee.time_budget == 0);
+        BOOST_TEST(testee.convergence_threshold == 0);
         BOOST_TEST(testee.verbose == false);
     }
 
@@ -37,6 +44,13 @@ BOOST_AUTO_TEST_SUITE(shrinkler_parameters_test)
         BOOST_TEST(testee.effort == 900);
         BOOST_TEST(testee.skip_length == 9000);
         BOOST_TEST(testee.references == 100000);
+        BOOST_TEST(testee.threads == 1);
+        BOOST_TEST(testee.precompute_matches == true);
+        BOOST_TEST(testee.range_index == false);
+        BOOST_TEST(testee.parse_block_size == 0);
+        BOOST_TEST(testee.chains == 1);
+        BOOST_TEST(testee.time_budget == 0);
+        BOOST_TEST(testee.convergence_threshold == 0);
         BOOST_TEST(testee.verbose == false);
     }
 